@@ -0,0 +1,1140 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR BENCHMARK
+ * ============================================================================
+ *
+ * Two suites:
+ *
+ *   Strategy suite (default): a standard set of single-threaded workloads
+ *   is run against every AllocationStrategy. Each run reports ns/op
+ *   percentiles, peak fragmentation and free blocks visited per search,
+ *   as a table, JSON (--format=json) or CSV (--format=csv).
+ *
+ *   Dispatch suite (--dispatch): every workload runs on the runtime-switched
+ *   MemoryAllocator and on the BasicMemoryAllocator specialised for the
+ *   same fit policy, and the ns/op of both are compared.
+ *
+ *   Index suite (--index): every workload runs First, Best and Next Fit
+ *   through the free-list bins and through the FreeBlockIndex scans
+ *   (HeapConfig::blockIndex); the ns/op of both are compared and the
+ *   blocks they hand out are checked to be the same.
+ *
+ *   Scaling suite (--scaling): every worker runs the same random alloc/free
+ *   mix and the total throughput is reported per thread count, for one
+ *   shared locked heap and for per-thread arenas with caches. A
+ *   producer/consumer run then measures cross-thread frees.
+ * ============================================================================
+ */
+
+#include "concurrent_allocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <iomanip>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmark settings
+/**
+ * BenchConfig Structure
+ *
+ * Members:
+ *   - scaling: Run the thread scaling suite instead of the strategy suite
+ *   - dispatch: Run the runtime vs. specialised dispatch comparison
+ *   - index: Run the bin walk vs. FreeBlockIndex scan comparison
+ *   - format: Strategy suite output: table, json or csv
+ *   - workload/strategy: Only run the named workload / strategy (empty = all)
+ *   - maxThreads: Largest thread count of the sweep (1, 2, 4, ... up to this)
+ *   - opsPerThread: Allocate/free operations per worker (per run in the
+ *                   strategy suite)
+ *   - liveSlots: Blocks each scaling worker keeps live at most
+ *   - heapSize: Heap of every strategy suite run (fixed, so failures show)
+ */
+struct BenchConfig
+{
+    bool scaling = false;
+    bool dispatch = false;
+    bool index = false;
+    std::string format = "table";
+    std::string workload;
+    std::string strategy;
+    size_t maxThreads = 64;
+    size_t opsPerThread = 200000;
+    size_t liveSlots = 64;
+    size_t heapSize = 16 * 1024 * 1024;
+};
+
+// Small fast PRNG so the workers do not share any state
+struct XorShift
+{
+    uint64_t state;
+
+    explicit XorShift(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    uint64_t Next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Uniform integer in [low, high]
+    size_t Range(size_t low, size_t high)
+    {
+        return low + Next() % (high - low + 1);
+    }
+
+    // Uniform double in [0, 1)
+    double Unit()
+    {
+        return (Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// ============================================================================
+// Strategy suite
+// ============================================================================
+
+// One pre-generated operation: allocate `size` bytes into `slot`, or free it
+struct BenchOp
+{
+    bool alloc;
+    uint32_t slot;
+    uint32_t size;
+};
+
+// Builds an operation list, handing out slot numbers and recycling them
+class OpBuilder
+{
+private:
+    std::vector<uint32_t> freeSlots;
+    uint32_t nextSlot = 0;
+
+public:
+    std::vector<BenchOp> ops;
+
+    uint32_t Alloc(size_t size)
+    {
+        uint32_t slot;
+        if (freeSlots.empty())
+        {
+            slot = nextSlot++;
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        ops.push_back({true, slot, static_cast<uint32_t>(size)});
+        return slot;
+    }
+
+    void Free(uint32_t slot)
+    {
+        ops.push_back({false, slot, 0});
+        freeSlots.push_back(slot);
+    }
+};
+
+// Log-normal size from a Box-Muller normal (portable across standard libraries)
+size_t LogNormalSize(XorShift &rng, double mu, double sigma, size_t low, size_t high)
+{
+    double u1 = std::max(rng.Unit(), 1e-12);
+    double u2 = rng.Unit();
+    double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    double size = std::exp(mu + sigma * normal);
+    return std::min(high, std::max(low, static_cast<size_t>(size)));
+}
+
+/**
+ * Random churn around a target live set: allocate while below the target,
+ * then free a random live block or allocate with equal probability
+ */
+template <typename SizeFn>
+std::vector<BenchOp> RandomChurn(size_t count, size_t target, XorShift &rng, SizeFn sizeOf)
+{
+    OpBuilder builder;
+    std::vector<uint32_t> live;
+
+    while (builder.ops.size() < count)
+    {
+        if (live.size() < target || (live.size() < 2 * target && rng.Next() % 2 == 0))
+        {
+            live.push_back(builder.Alloc(sizeOf(rng)));
+        }
+        else
+        {
+            size_t index = rng.Next() % live.size();
+            builder.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    return std::move(builder.ops);
+}
+
+// Uniform small sizes (16-128 bytes) with random frees
+std::vector<BenchOp> UniformSmall(size_t count, XorShift &rng)
+{
+    return RandomChurn(count, 1024, rng, [](XorShift &r) { return r.Range(16, 128); });
+}
+
+// Mostly small blocks with a 10% tail of 4-16 KB buffers
+std::vector<BenchOp> Bimodal(size_t count, XorShift &rng)
+{
+    return RandomChurn(count, 1024, rng, [](XorShift &r)
+                       { return r.Next() % 10 == 0 ? r.Range(4096, 16384) : r.Range(16, 64); });
+}
+
+// Log-normal sizes (median ~245 bytes, long tail up to 64 KB)
+std::vector<BenchOp> LogNormal(size_t count, XorShift &rng)
+{
+    return RandomChurn(count, 1024, rng, [](XorShift &r) { return LogNormalSize(r, 5.5, 1.0, 8, 65536); });
+}
+
+// Stack-like bursts over a long-lived base: allocate a burst, free it in reverse
+std::vector<BenchOp> LifoChurn(size_t count, XorShift &rng)
+{
+    OpBuilder builder;
+    for (size_t i = 0; i < 256 && builder.ops.size() < count; i++)
+    {
+        builder.Alloc(rng.Range(16, 512));
+    }
+
+    std::vector<uint32_t> stack;
+    while (builder.ops.size() < count)
+    {
+        size_t burst = rng.Range(1, 64);
+        for (size_t i = 0; i < burst && builder.ops.size() < count; i++)
+        {
+            stack.push_back(builder.Alloc(rng.Range(16, 512)));
+        }
+        while (!stack.empty() && builder.ops.size() < count)
+        {
+            builder.Free(stack.back());
+            stack.pop_back();
+        }
+    }
+    return std::move(builder.ops);
+}
+
+// A bounded queue: once full, every allocation frees the oldest block
+std::vector<BenchOp> FifoQueue(size_t count, XorShift &rng)
+{
+    OpBuilder builder;
+    std::deque<uint32_t> queue;
+
+    while (builder.ops.size() < count)
+    {
+        if (queue.size() == 512)
+        {
+            builder.Free(queue.front());
+            queue.pop_front();
+        }
+        else
+        {
+            queue.push_back(builder.Alloc(rng.Range(16, 1024)));
+        }
+    }
+    return std::move(builder.ops);
+}
+
+// Every block gets an exponentially distributed lifetime (mean 500 operations)
+std::vector<BenchOp> RandomLifetimes(size_t count, XorShift &rng)
+{
+    OpBuilder builder;
+    using Death = std::pair<size_t, uint32_t>; // (operation index, slot)
+    std::priority_queue<Death, std::vector<Death>, std::greater<Death>> deaths;
+
+    while (builder.ops.size() < count)
+    {
+        size_t now = builder.ops.size();
+        if (!deaths.empty() && deaths.top().first <= now)
+        {
+            builder.Free(deaths.top().second);
+            deaths.pop();
+        }
+        else
+        {
+            uint32_t slot = builder.Alloc(LogNormalSize(rng, 6.0, 1.2, 16, 32768));
+            size_t lifetime = static_cast<size_t>(-500.0 * std::log(std::max(rng.Unit(), 1e-12)));
+            deaths.push({now + 1 + lifetime, slot});
+        }
+    }
+    return std::move(builder.ops);
+}
+
+// A named workload generator
+struct Workload
+{
+    const char *name;
+    std::vector<BenchOp> (*generate)(size_t count, XorShift &rng);
+};
+
+const Workload WORKLOADS[] = {
+    {"uniform-small", UniformSmall},
+    {"bimodal", Bimodal},
+    {"log-normal", LogNormal},
+    {"lifo-churn", LifoChurn},
+    {"fifo-queue", FifoQueue},
+    {"random-lifetimes", RandomLifetimes},
+};
+
+// Results of one (workload, strategy) run
+struct SuiteResult
+{
+    std::string workload;
+    std::string strategy;
+    size_t ops;
+    size_t failures;
+    double meanNs;
+    uint64_t p50Ns, p90Ns, p99Ns, p999Ns, maxNs;
+    double peakFragmentation;
+    double finalFragmentation;
+    double visitsPerSearch;
+};
+
+/**
+ * Generate a workload's operation list from the fixed seed
+ */
+std::vector<BenchOp> GenerateOps(const Workload &workload, const BenchConfig &config, uint32_t &slotCount)
+{
+    XorShift rng(42);
+    std::vector<BenchOp> ops = workload.generate(config.opsPerThread, rng);
+    slotCount = 0;
+    for (const BenchOp &op : ops)
+    {
+        slotCount = std::max(slotCount, op.slot + 1);
+    }
+    return ops;
+}
+
+/**
+ * Run one operation list against one strategy, timing every operation
+ *
+ * Frees of slots whose allocation failed are skipped (and not timed).
+ * Blocks still live at the end are released after the measurement.
+ */
+SuiteResult RunWorkload(const Workload &workload, const std::vector<BenchOp> &ops, size_t slotCount,
+                        AllocationStrategy strategy, const BenchConfig &config)
+{
+    HeapConfig heapConfig;
+    heapConfig.heapSize = config.heapSize;
+
+    MemoryAllocator allocator(strategy, heapConfig);
+    allocator.SetVerbose(false);
+
+    std::vector<void *> slots(slotCount, nullptr);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(ops.size());
+
+    SuiteResult result{};
+    result.workload = workload.name;
+    result.strategy = StrategyKey(strategy);
+
+    for (const BenchOp &op : ops)
+    {
+        if (!op.alloc && !slots[op.slot])
+        {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (op.alloc)
+        {
+            slots[op.slot] = allocator.Allocate(op.size);
+        }
+        else
+        {
+            allocator.Deallocate(slots[op.slot]);
+            slots[op.slot] = nullptr;
+        }
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+
+        if (op.alloc && !slots[op.slot])
+        {
+            result.failures++;
+        }
+        result.peakFragmentation = std::max(result.peakFragmentation, allocator.GetStats().fragmentation);
+    }
+
+    MemoryStats stats = allocator.GetStats();
+    result.finalFragmentation = stats.fragmentation;
+    result.visitsPerSearch = stats.searches > 0 ? static_cast<double>(stats.blocksVisited) / stats.searches : 0.0;
+
+    for (void *ptr : slots)
+    {
+        if (ptr)
+        {
+            allocator.Deallocate(ptr);
+        }
+    }
+
+    result.ops = latencies.size();
+    if (!latencies.empty())
+    {
+        uint64_t total = 0;
+        for (uint64_t ns : latencies)
+        {
+            total += ns;
+        }
+        result.meanNs = static_cast<double>(total) / latencies.size();
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p)
+        {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+        };
+        result.p50Ns = percentile(0.50);
+        result.p90Ns = percentile(0.90);
+        result.p99Ns = percentile(0.99);
+        result.p999Ns = percentile(0.999);
+        result.maxNs = latencies.back();
+    }
+    return result;
+}
+
+/**
+ * Print the strategy suite results in the requested format
+ */
+void PrintSuiteResults(const std::vector<SuiteResult> &results, const BenchConfig &config)
+{
+    if (config.format == "csv")
+    {
+        std::cout << "workload,strategy,ops,failures,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,"
+                     "peak_fragmentation,final_fragmentation,visits_per_search\n";
+        for (const SuiteResult &r : results)
+        {
+            std::cout << r.workload << ',' << r.strategy << ',' << r.ops << ',' << r.failures << ','
+                      << std::fixed << std::setprecision(1) << r.meanNs << ','
+                      << r.p50Ns << ',' << r.p90Ns << ',' << r.p99Ns << ',' << r.p999Ns << ',' << r.maxNs << ','
+                      << std::setprecision(4) << r.peakFragmentation << ',' << r.finalFragmentation << ','
+                      << std::setprecision(2) << r.visitsPerSearch << "\n";
+        }
+        return;
+    }
+
+    if (config.format == "json")
+    {
+        std::cout << "{\n  \"ops\": " << config.opsPerThread << ",\n  \"heapSize\": " << config.heapSize
+                  << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const SuiteResult &r = results[i];
+            std::cout << "    {\"workload\": \"" << r.workload << "\", \"strategy\": \"" << r.strategy
+                      << "\", \"ops\": " << r.ops << ", \"failures\": " << r.failures
+                      << std::fixed << std::setprecision(1) << ", \"meanNs\": " << r.meanNs
+                      << ", \"p50Ns\": " << r.p50Ns << ", \"p90Ns\": " << r.p90Ns
+                      << ", \"p99Ns\": " << r.p99Ns << ", \"p999Ns\": " << r.p999Ns
+                      << ", \"maxNs\": " << r.maxNs
+                      << std::setprecision(4) << ", \"peakFragmentation\": " << r.peakFragmentation
+                      << ", \"finalFragmentation\": " << r.finalFragmentation
+                      << std::setprecision(2) << ", \"visitsPerSearch\": " << r.visitsPerSearch << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}\n";
+        return;
+    }
+
+    std::cout << "=== Allocation Strategy Suite ===\n";
+    std::cout << "Operations per run: " << config.opsPerThread << ", heap: " << config.heapSize << " bytes\n\n";
+    std::cout << std::left << std::setw(18) << "Workload" << std::setw(8) << "Strategy"
+              << std::right << std::setw(10) << "mean ns" << std::setw(8) << "p50"
+              << std::setw(8) << "p99" << std::setw(9) << "p99.9" << std::setw(10) << "max"
+              << std::setw(11) << "Peak frag" << std::setw(13) << "Visits/srch"
+              << std::setw(10) << "Failures" << "\n";
+    std::cout << std::string(105, '-') << "\n";
+    for (const SuiteResult &r : results)
+    {
+        std::cout << std::left << std::setw(18) << r.workload << std::setw(8) << r.strategy
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(10) << r.meanNs
+                  << std::setw(8) << r.p50Ns << std::setw(8) << r.p99Ns << std::setw(9) << r.p999Ns
+                  << std::setw(10) << r.maxNs
+                  << std::setprecision(2) << std::setw(10) << r.peakFragmentation * 100 << "%"
+                  << std::setw(13) << r.visitsPerSearch << std::setw(10) << r.failures << "\n";
+    }
+}
+
+/**
+ * Run every selected workload against every selected strategy
+ *
+ * Each workload's operation list is generated once from a fixed seed, so
+ * all strategies (and all versions of the allocator) see the same requests.
+ */
+bool RunStrategySuite(const BenchConfig &config)
+{
+    std::vector<SuiteResult> results;
+    bool matched = false;
+
+    for (const Workload &workload : WORKLOADS)
+    {
+        if (!config.workload.empty() && config.workload != workload.name)
+            continue;
+
+        uint32_t slotCount = 0;
+        std::vector<BenchOp> ops = GenerateOps(workload, config, slotCount);
+
+        for (AllocationStrategy strategy : ALL_STRATEGIES)
+        {
+            if (!config.strategy.empty() && config.strategy != StrategyKey(strategy))
+                continue;
+
+            matched = true;
+            results.push_back(RunWorkload(workload, ops, slotCount, strategy, config));
+        }
+    }
+
+    if (!matched)
+    {
+        std::cout << "ERROR: No workload/strategy matches the filters.\n";
+        return false;
+    }
+
+    PrintSuiteResults(results, config);
+    return true;
+}
+
+// ============================================================================
+// Dispatch suite
+// ============================================================================
+
+// Runtime-dispatched vs. specialised timings of one (workload, strategy)
+struct DispatchResult
+{
+    std::string workload;
+    std::string strategy;
+    double runtimeNs;     // ns/op of MemoryAllocator
+    double specialisedNs; // ns/op of BasicMemoryAllocator<Policy>
+};
+
+/**
+ * Replay an operation list on a fresh allocator and return the ns/op of
+ * the whole loop (no per-operation timers, so the dispatch cost shows)
+ */
+template <typename Allocator>
+double TimeOps(Allocator &allocator, const std::vector<BenchOp> &ops, uint32_t slotCount)
+{
+    std::vector<void *> slots(slotCount, nullptr);
+    allocator.SetVerbose(false);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const BenchOp &op : ops)
+    {
+        if (op.alloc)
+        {
+            slots[op.slot] = allocator.Allocate(op.size);
+        }
+        else if (slots[op.slot])
+        {
+            allocator.Deallocate(slots[op.slot]);
+            slots[op.slot] = nullptr;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops.size();
+}
+
+/**
+ * Best-of-five ns/op of one policy, runtime-dispatched and specialised
+ * (the two runs alternate so drift affects both alike)
+ */
+template <typename Policy>
+void CompareDispatch(const Workload &workload, const std::vector<BenchOp> &ops, uint32_t slotCount,
+                     const BenchConfig &config, std::vector<DispatchResult> &results)
+{
+    if (!config.strategy.empty() && config.strategy != StrategyKey(Policy::STRATEGY))
+        return;
+
+    HeapConfig heapConfig;
+    heapConfig.heapSize = config.heapSize;
+
+    DispatchResult result{workload.name, StrategyKey(Policy::STRATEGY), 1e300, 1e300};
+    for (int rep = 0; rep < 5; rep++)
+    {
+        MemoryAllocator runtime(Policy::STRATEGY, heapConfig);
+        result.runtimeNs = std::min(result.runtimeNs, TimeOps(runtime, ops, slotCount));
+
+        BasicMemoryAllocator<Policy> specialised(heapConfig);
+        result.specialisedNs = std::min(result.specialisedNs, TimeOps(specialised, ops, slotCount));
+    }
+    results.push_back(result);
+}
+
+/**
+ * Compare runtime dispatch against the specialised allocators
+ */
+bool RunDispatchSuite(const BenchConfig &config)
+{
+    std::vector<DispatchResult> results;
+
+    for (const Workload &workload : WORKLOADS)
+    {
+        if (!config.workload.empty() && config.workload != workload.name)
+            continue;
+
+        uint32_t slotCount = 0;
+        std::vector<BenchOp> ops = GenerateOps(workload, config, slotCount);
+
+        CompareDispatch<FirstFitPolicy>(workload, ops, slotCount, config, results);
+        CompareDispatch<BestFitPolicy>(workload, ops, slotCount, config, results);
+        CompareDispatch<TreeBestFitPolicy>(workload, ops, slotCount, config, results);
+        CompareDispatch<BuddyPolicy>(workload, ops, slotCount, config, results);
+        CompareDispatch<NextFitPolicy>(workload, ops, slotCount, config, results);
+        CompareDispatch<WorstFitPolicy>(workload, ops, slotCount, config, results);
+    }
+
+    if (results.empty())
+    {
+        std::cout << "ERROR: No workload/strategy matches the filters.\n";
+        return false;
+    }
+
+    if (config.format == "csv")
+    {
+        std::cout << "workload,strategy,runtime_ns,specialised_ns,speedup\n";
+        for (const DispatchResult &r : results)
+        {
+            std::cout << r.workload << ',' << r.strategy << ',' << std::fixed << std::setprecision(2)
+                      << r.runtimeNs << ',' << r.specialisedNs << ',' << std::setprecision(3)
+                      << r.runtimeNs / r.specialisedNs << "\n";
+        }
+    }
+    else if (config.format == "json")
+    {
+        std::cout << "{\n  \"ops\": " << config.opsPerThread << ",\n  \"dispatch\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const DispatchResult &r = results[i];
+            std::cout << "    {\"workload\": \"" << r.workload << "\", \"strategy\": \"" << r.strategy
+                      << "\", " << std::fixed << std::setprecision(2) << "\"runtimeNs\": " << r.runtimeNs
+                      << ", \"specialisedNs\": " << r.specialisedNs << ", \"speedup\": "
+                      << std::setprecision(3) << r.runtimeNs / r.specialisedNs << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}\n";
+    }
+    else
+    {
+        std::cout << "=== Runtime Dispatch vs. Specialised Policies ===\n";
+        std::cout << "Operations per run: " << config.opsPerThread << ", best of 5\n\n";
+        std::cout << std::left << std::setw(18) << "Workload" << std::setw(10) << "Strategy"
+                  << std::right << std::setw(14) << "Runtime ns/op" << std::setw(18) << "Specialised ns/op"
+                  << std::setw(10) << "Speedup" << "\n";
+        std::cout << std::string(70, '-') << "\n";
+        for (const DispatchResult &r : results)
+        {
+            std::cout << std::left << std::setw(18) << r.workload << std::setw(10) << r.strategy
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << r.runtimeNs << std::setw(18) << r.specialisedNs
+                      << std::setprecision(3) << std::setw(9) << r.runtimeNs / r.specialisedNs << "x\n";
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Index suite
+// ============================================================================
+
+// Bin walk vs. index scan timings of one (workload, strategy)
+struct IndexResult
+{
+    std::string workload;
+    std::string strategy;
+    double binsNs;        // ns/op searching the free-list bins
+    double indexNs;       // ns/op scanning the FreeBlockIndex
+    double binsVisits;    // Free blocks visited per search
+    double indexVisits;   // Index slots scanned per search
+    bool sameBlocks;      // Both placed every allocation at the same offset
+};
+
+/**
+ * Replay an operation list untimed and hash where every allocation landed
+ * (its offset in the heap, or a miss), so two allocators can be compared
+ */
+uint64_t PlacementDigest(MemoryAllocator &allocator, const std::vector<BenchOp> &ops, uint32_t slotCount)
+{
+    std::vector<void *> slots(slotCount, nullptr);
+    allocator.SetVerbose(false);
+
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    for (const BenchOp &op : ops)
+    {
+        if (op.alloc)
+        {
+            slots[op.slot] = allocator.Allocate(op.size);
+            digest = (digest ^ (slots[op.slot] ? allocator.BlockOffset(slots[op.slot]) : SIZE_MAX)) * 0x100000001b3ULL;
+        }
+        else if (slots[op.slot])
+        {
+            allocator.Deallocate(slots[op.slot]);
+            slots[op.slot] = nullptr;
+        }
+    }
+    return digest;
+}
+
+/**
+ * Best-of-five ns/op of one strategy with and without the index (the two
+ * runs alternate so drift affects both alike)
+ */
+void CompareIndex(const Workload &workload, const std::vector<BenchOp> &ops, uint32_t slotCount,
+                  AllocationStrategy strategy, const BenchConfig &config, std::vector<IndexResult> &results)
+{
+    if (!config.strategy.empty() && config.strategy != StrategyKey(strategy))
+        return;
+
+    HeapConfig binsConfig;
+    binsConfig.heapSize = config.heapSize;
+    HeapConfig indexConfig = binsConfig;
+    indexConfig.blockIndex = true;
+
+    IndexResult result{workload.name, StrategyKey(strategy), 1e300, 1e300, 0.0, 0.0, false};
+    for (int rep = 0; rep < 5; rep++)
+    {
+        MemoryAllocator bins(strategy, binsConfig);
+        result.binsNs = std::min(result.binsNs, TimeOps(bins, ops, slotCount));
+
+        MemoryAllocator indexed(strategy, indexConfig);
+        result.indexNs = std::min(result.indexNs, TimeOps(indexed, ops, slotCount));
+
+        if (rep == 0)
+        {
+            MemoryStats binsStats = bins.GetStats();
+            MemoryStats indexStats = indexed.GetStats();
+            result.binsVisits = binsStats.searches ? static_cast<double>(binsStats.blocksVisited) / binsStats.searches : 0.0;
+            result.indexVisits = indexStats.searches ? static_cast<double>(indexStats.blocksVisited) / indexStats.searches : 0.0;
+        }
+    }
+
+    MemoryAllocator bins(strategy, binsConfig);
+    MemoryAllocator indexed(strategy, indexConfig);
+    result.sameBlocks = PlacementDigest(bins, ops, slotCount) == PlacementDigest(indexed, ops, slotCount);
+    results.push_back(result);
+}
+
+/**
+ * Compare the free-list bin walks against the FreeBlockIndex scans
+ */
+bool RunIndexSuite(const BenchConfig &config)
+{
+    std::vector<IndexResult> results;
+
+    for (const Workload &workload : WORKLOADS)
+    {
+        if (!config.workload.empty() && config.workload != workload.name)
+            continue;
+
+        uint32_t slotCount = 0;
+        std::vector<BenchOp> ops = GenerateOps(workload, config, slotCount);
+
+        CompareIndex(workload, ops, slotCount, AllocationStrategy::FIRST_FIT, config, results);
+        CompareIndex(workload, ops, slotCount, AllocationStrategy::BEST_FIT, config, results);
+        CompareIndex(workload, ops, slotCount, AllocationStrategy::NEXT_FIT, config, results);
+    }
+
+    if (results.empty())
+    {
+        std::cout << "ERROR: No workload/strategy matches the filters (the index serves first and best).\n";
+        return false;
+    }
+
+    bool allSame = true;
+    for (const IndexResult &r : results)
+    {
+        allSame = allSame && r.sameBlocks;
+    }
+
+    if (config.format == "csv")
+    {
+        std::cout << "workload,strategy,bins_ns,index_ns,speedup,bins_visits,index_slots,same_blocks\n";
+        for (const IndexResult &r : results)
+        {
+            std::cout << r.workload << ',' << r.strategy << ',' << std::fixed << std::setprecision(2)
+                      << r.binsNs << ',' << r.indexNs << ',' << std::setprecision(3) << r.binsNs / r.indexNs << ','
+                      << std::setprecision(2) << r.binsVisits << ',' << r.indexVisits << ','
+                      << (r.sameBlocks ? "yes" : "no") << "\n";
+        }
+    }
+    else if (config.format == "json")
+    {
+        std::cout << "{\n  \"ops\": " << config.opsPerThread << ",\n  \"index\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const IndexResult &r = results[i];
+            std::cout << "    {\"workload\": \"" << r.workload << "\", \"strategy\": \"" << r.strategy
+                      << "\", " << std::fixed << std::setprecision(2) << "\"binsNs\": " << r.binsNs
+                      << ", \"indexNs\": " << r.indexNs << ", \"speedup\": " << std::setprecision(3)
+                      << r.binsNs / r.indexNs << std::setprecision(2) << ", \"binsVisits\": " << r.binsVisits
+                      << ", \"indexSlots\": " << r.indexVisits
+                      << ", \"sameBlocks\": " << (r.sameBlocks ? "true" : "false") << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}\n";
+    }
+    else
+    {
+        std::cout << "=== Free-List Bins vs. Free-Block Index ===\n";
+        std::cout << "Operations per run: " << config.opsPerThread << ", heap: " << config.heapSize
+                  << " bytes, best of 5, " << FREE_INDEX_LANES << " sizes per compare\n\n";
+        std::cout << std::left << std::setw(18) << "Workload" << std::setw(10) << "Strategy"
+                  << std::right << std::setw(11) << "Bins ns/op" << std::setw(12) << "Index ns/op"
+                  << std::setw(10) << "Speedup" << std::setw(13) << "Bin visits" << std::setw(13) << "Index slots"
+                  << std::setw(7) << "Same" << "\n";
+        std::cout << std::string(94, '-') << "\n";
+        for (const IndexResult &r : results)
+        {
+            std::cout << std::left << std::setw(18) << r.workload << std::setw(10) << r.strategy
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(11) << r.binsNs << std::setw(12) << r.indexNs
+                      << std::setprecision(3) << std::setw(9) << r.binsNs / r.indexNs << "x"
+                      << std::setprecision(1) << std::setw(13) << r.binsVisits << std::setw(13) << r.indexVisits
+                      << std::setw(7) << (r.sameBlocks ? "yes" : "NO") << "\n";
+        }
+    }
+    return allSame;
+}
+
+// ============================================================================
+// Scaling suite
+// ============================================================================
+
+/**
+ * Worker - Random alloc/free mix over a fixed number of slots
+ *
+ * Sizes are mostly small (16-256 bytes) with an occasional larger block,
+ * like a typical object-heavy workload.
+ */
+void Worker(ConcurrentAllocator &allocator, const BenchConfig &config, size_t id, size_t &failures)
+{
+    XorShift rng(id + 1);
+    std::vector<void *> slots(config.liveSlots, nullptr);
+
+    for (size_t op = 0; op < config.opsPerThread; op++)
+    {
+        size_t slot = rng.Next() % slots.size();
+        if (slots[slot])
+        {
+            allocator.Deallocate(slots[slot]);
+            slots[slot] = nullptr;
+        }
+        else
+        {
+            uint64_t r = rng.Next();
+            size_t size = (r % 16 == 0) ? 1024 + r % 3072 : 16 + r % 241;
+            slots[slot] = allocator.Allocate(size);
+            if (!slots[slot])
+            {
+                failures++;
+            }
+        }
+    }
+
+    for (void *ptr : slots)
+    {
+        allocator.Deallocate(ptr);
+    }
+    allocator.FlushThreadCache();
+}
+
+/**
+ * Run one configuration and return its throughput in operations per second
+ */
+double RunScaling(size_t threads, size_t arenas, size_t cacheDepth, const BenchConfig &config,
+                  ConcurrentStats &stats, size_t &failures)
+{
+    HeapConfig heapConfig;
+    heapConfig.heapSize = 4 * 1024 * 1024;
+    heapConfig.growable = true;
+
+    ConcurrentAllocator allocator(arenas, AllocationStrategy::FIRST_FIT, heapConfig, cacheDepth);
+
+    std::vector<size_t> workerFailures(threads, 0);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < threads; i++)
+    {
+        workers.emplace_back(Worker, std::ref(allocator), std::cref(config), i, std::ref(workerFailures[i]));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    stats = allocator.GetStats();
+    failures = 0;
+    for (size_t f : workerFailures)
+    {
+        failures += f;
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(threads * config.opsPerThread) / seconds;
+}
+
+// Single-producer, single-consumer ring of pointers between two workers
+struct PointerRing
+{
+    static constexpr size_t CAPACITY = 1024;
+
+    void *slots[CAPACITY];
+    alignas(64) std::atomic<size_t> head{0}; // Next slot to read
+    alignas(64) std::atomic<size_t> tail{0}; // Next slot to write
+
+    bool Push(void *ptr)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY)
+            return false;
+        slots[t % CAPACITY] = ptr;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(void *&ptr)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        ptr = slots[h % CAPACITY];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/**
+ * Producer/consumer pairs: one thread allocates, the other frees, so every
+ * free is a remote free. Returns blocks moved per second.
+ */
+double RunPipeline(size_t pairs, size_t cacheDepth, const BenchConfig &config, ConcurrentStats &stats)
+{
+    HeapConfig heapConfig;
+    heapConfig.heapSize = 4 * 1024 * 1024;
+    heapConfig.growable = true;
+
+    ConcurrentAllocator allocator(pairs * 2, AllocationStrategy::FIRST_FIT, heapConfig, cacheDepth);
+    std::vector<std::unique_ptr<PointerRing>> rings;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        rings.push_back(std::make_unique<PointerRing>());
+    }
+
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs; i++)
+    {
+        PointerRing &ring = *rings[i];
+        workers.emplace_back([&allocator, &ring, &config, i]
+        {
+            XorShift rng(i + 1);
+            for (size_t op = 0; op < config.opsPerThread; op++)
+            {
+                void *ptr = allocator.Allocate(16 + rng.Next() % 241);
+                while (!ring.Push(ptr))
+                {
+                    std::this_thread::yield();
+                }
+            }
+            ring.Push(nullptr);
+        });
+        workers.emplace_back([&allocator, &ring]
+        {
+            void *ptr = nullptr;
+            for (;;)
+            {
+                if (!ring.Pop(ptr))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (!ptr)
+                    break;
+                allocator.Deallocate(ptr);
+            }
+            allocator.FlushThreadCache();
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    allocator.DrainAllRemoteFrees();
+    stats = allocator.GetStats();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(pairs * config.opsPerThread) / seconds;
+}
+
+/**
+ * Parse a numeric --name=value argument
+ */
+bool ParseCount(const std::string &arg, const std::string &name, size_t &value)
+{
+    if (arg.compare(0, name.size(), name) != 0)
+        return false;
+
+    value = std::strtoull(arg.c_str() + name.size(), nullptr, 10);
+    return true;
+}
+
+/**
+ * Thread scaling and producer/consumer runs of the concurrent front-end
+ */
+void RunScalingSuite(const BenchConfig &config)
+{
+    std::cout << "=== Concurrent Allocator Scaling ===\n";
+    std::cout << "Operations per thread: " << config.opsPerThread
+              << ", hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+    std::cout << std::left << std::setw(10) << "Threads"
+              << std::right << std::setw(18) << "1 heap (ops/s)"
+              << std::setw(22) << "N heaps+cache (ops/s)"
+              << std::setw(10) << "Speedup"
+              << std::setw(12) << "Cache hit" << "\n";
+    std::cout << std::string(72, '-') << "\n";
+
+    for (size_t threads = 1; threads <= config.maxThreads; threads *= 2)
+    {
+        ConcurrentStats lockedStats, cachedStats;
+        size_t lockedFailures, cachedFailures;
+
+        double locked = RunScaling(threads, 1, 0, config, lockedStats, lockedFailures);
+        double cached = RunScaling(threads, threads, CACHE_DEFAULT_DEPTH, config, cachedStats, cachedFailures);
+
+        size_t lookups = cachedStats.cacheHits + cachedStats.cacheMisses;
+        double hitRate = lookups > 0 ? 100.0 * cachedStats.cacheHits / lookups : 0.0;
+
+        std::cout << std::left << std::setw(10) << threads
+                  << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(18) << locked
+                  << std::setw(22) << cached
+                  << std::setprecision(2)
+                  << std::setw(9) << cached / locked << "x"
+                  << std::setw(11) << hitRate << "%";
+        if (lockedFailures + cachedFailures > 0)
+        {
+            std::cout << "  (" << lockedFailures + cachedFailures << " failed allocations)";
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "\n=== Producer/Consumer (remote frees) ===\n\n";
+    std::cout << std::left << std::setw(10) << "Pairs"
+              << std::right << std::setw(16) << "Blocks/s"
+              << std::setw(14) << "Remote frees"
+              << std::setw(10) << "Drains"
+              << std::setw(16) << "Avg drain (us)"
+              << std::setw(16) << "Max drain (us)" << "\n";
+    std::cout << std::string(82, '-') << "\n";
+
+    for (size_t pairs = 1; pairs * 2 <= std::max<size_t>(2, config.maxThreads); pairs *= 2)
+    {
+        ConcurrentStats stats;
+        double rate = RunPipeline(pairs, CACHE_DEFAULT_DEPTH, config, stats);
+        double avgDrain = stats.remoteDrains > 0 ? stats.drainNanos / 1000.0 / stats.remoteDrains : 0.0;
+
+        std::cout << std::left << std::setw(10) << pairs
+                  << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << rate
+                  << std::setw(14) << stats.remoteFrees
+                  << std::setw(10) << stats.remoteDrains
+                  << std::setprecision(2)
+                  << std::setw(16) << avgDrain
+                  << std::setw(16) << stats.maxDrainNanos / 1000.0 << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        AllocationStrategy strategy;
+        bool valid = true;
+
+        if (arg == "--scaling")
+        {
+            config.scaling = true;
+        }
+        else if (arg == "--dispatch")
+        {
+            config.dispatch = true;
+        }
+        else if (arg == "--index")
+        {
+            config.index = true;
+        }
+        else if (arg.rfind("--format=", 0) == 0)
+        {
+            config.format = arg.substr(9);
+            valid = config.format == "table" || config.format == "json" || config.format == "csv";
+        }
+        else if (arg.rfind("--workload=", 0) == 0)
+        {
+            config.workload = arg.substr(11);
+        }
+        else if (arg.rfind("--strategy=", 0) == 0)
+        {
+            config.strategy = arg.substr(11);
+            valid = ParseStrategy(config.strategy, strategy);
+        }
+        else if (!ParseCount(arg, "--threads=", config.maxThreads) &&
+                 !ParseCount(arg, "--ops=", config.opsPerThread) &&
+                 !ParseCount(arg, "--heap-size=", config.heapSize))
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cout << "Usage: " << argv[0] << " [--format=table|json|csv] [--workload=NAME]\n"
+                      << "       [--strategy=first|best|tree|buddy|next|worst] [--ops=N] [--heap-size=BYTES]\n"
+                      << "       " << argv[0] << " --dispatch [same filters and formats]\n"
+                      << "       " << argv[0] << " --index [same filters and formats]\n"
+                      << "       " << argv[0] << " --scaling [--threads=N] [--ops=N]\n"
+                      << "Workloads:";
+            for (const Workload &workload : WORKLOADS)
+            {
+                std::cout << " " << workload.name;
+            }
+            std::cout << "\n";
+            return 1;
+        }
+    }
+    config.maxThreads = std::max<size_t>(1, config.maxThreads);
+    config.opsPerThread = std::max<size_t>(1, config.opsPerThread);
+    config.heapSize = std::max<size_t>(HEAP_PAGE_SIZE, config.heapSize);
+
+    if (config.scaling)
+    {
+        RunScalingSuite(config);
+        return 0;
+    }
+
+    if (config.dispatch)
+    {
+        return RunDispatchSuite(config) ? 0 : 1;
+    }
+
+    if (config.index)
+    {
+        return RunIndexSuite(config) ? 0 : 1;
+    }
+
+    return RunStrategySuite(config) ? 0 : 1;
+}
@@ -0,0 +1,662 @@
+/**
+ * ============================================================================
+ * CONCURRENT ALLOCATOR - Multi-Arena Thread-Safe Front-End
+ * ============================================================================
+ *
+ * Runs several independent MemoryAllocator heaps, each behind its own lock,
+ * with a small per-thread cache of freed blocks in front of them.
+ * ============================================================================
+ */
+
+#ifndef CONCURRENT_ALLOCATOR_H
+#define CONCURRENT_ALLOCATOR_H
+
+#include "memory_allocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Concurrent allocator constants
+constexpr size_t CACHE_MIN_SHIFT = 4;                 // Smallest cached class is 16 bytes
+constexpr size_t CACHE_NUM_CLASSES = 12;              // 16 bytes .. 32 KB
+constexpr size_t CACHE_MAX_DEPTH = 64;                // Upper bound on blocks per class
+constexpr size_t CACHE_DEFAULT_DEPTH = 32;            // Blocks kept per class by default
+constexpr BlockMagic CACHED_MAGIC = static_cast<BlockMagic>(0xCAC4EDB1); // Header canary while a block sits in a cache
+constexpr BlockMagic REMOTE_MAGIC = static_cast<BlockMagic>(0x4E30F4EE); // Header canary while a block waits in a remote-free queue
+
+// Aggregated statistics snapshot
+/**
+ * ConcurrentStats Structure
+ *
+ * Heap statistics summed over every arena, plus the thread cache counters.
+ * Blocks held in thread caches still count as allocated in the heap
+ * figures; cachedBlocks/cachedBytes say how much of that is idle.
+ *
+ * Members:
+ *   - heap: Sum of the per-arena MemoryStats (fragmentation recomputed)
+ *   - arenas: Number of independent heaps
+ *   - cacheHits/cacheMisses: Allocations served by / past the thread caches
+ *   - cacheFlushes: Blocks handed back from a full cache to their heap
+ *   - cachedBlocks/cachedBytes: Freed blocks currently parked in caches
+ *   - remoteFrees/remoteBytes: Blocks freed by a thread bound to another arena
+ *   - remoteDrains: Batches taken off the remote-free queues
+ *   - remotePending: Remote frees not drained yet
+ *   - drainNanos/maxDrainNanos: Time spent draining, in total / longest batch
+ */
+struct ConcurrentStats
+{
+    MemoryStats heap;      // Sum of the per-arena statistics
+    size_t arenas;         // Number of independent heaps
+    size_t cacheHits;      // Allocations served from a thread cache
+    size_t cacheMisses;    // Allocations that went to a heap
+    size_t cacheFlushes;   // Blocks returned from a full cache to their heap
+    size_t cachedBlocks;   // Freed blocks parked in thread caches
+    size_t cachedBytes;    // Bytes of those blocks
+    size_t remoteFrees;    // Blocks freed from a thread bound to another arena
+    size_t remoteBytes;    // Bytes of those blocks
+    size_t remoteDrains;   // Batches taken off the remote-free queues
+    size_t remotePending;  // Remote frees waiting to be drained
+    size_t drainNanos;     // Total time spent draining
+    size_t maxDrainNanos;  // Longest single drain
+};
+
+// Thread-safe allocator front-end
+/**
+ * ConcurrentAllocator Class
+ *
+ * Owns N MemoryAllocator instances ("arenas"), each with its own mutex.
+ * Every thread is bound to one arena on its first request (round-robin),
+ * so threads only contend when they share an arena. Frees go back to the
+ * arena that owns the block, found from the heapId in its header.
+ *
+ * Each thread also keeps a cache of recently freed blocks per power-of-two
+ * size class. A free followed by an allocation of a similar size never
+ * takes a lock; a class that fills up returns half of its blocks to their
+ * heaps in one go.
+ *
+ * A block freed by a thread bound to a different arena does not take the
+ * owner's lock. It is pushed onto the owning arena's lock-free remote-free
+ * queue (a multi-producer, single-consumer stack linked through the block
+ * headers), and a thread of that arena drains the whole queue in one batch
+ * on its next Allocate or Deallocate, through the normal Deallocate and
+ * coalescing path.
+ *
+ * A pointer is matched to its arena by address before its header is read:
+ * every arena publishes the address ranges of its heap in a lock-free
+ * list (ranges are only ever added, since a heap never gives an arena
+ * back), so stray pointers are rejected without touching memory. The
+ * lock-free paths read only the header fields the owner leaves alone
+ * while a block is allocated; with compact headers the size shares a word
+ * with a flag the owner rewrites when a neighbour changes state, so those
+ * blocks skip the caches and remote queues and are freed under the owning
+ * arena's lock.
+ *
+ * Key Features:
+ *   - Independent arenas, one lock each, no global lock
+ *   - Lock-free fast path through the per-thread caches
+ *   - Lock-free remote frees, drained in batches by the owning arena
+ *   - Double frees of cached or queued blocks are caught by separate header canaries
+ *   - Cache depth 0 turns the caches off (plain locked arenas)
+ */
+class ConcurrentAllocator
+{
+private:
+    // One arena: an engine instance and the lock that guards it, kept on
+    // separate cache lines so neighbouring arenas do not false-share
+    struct alignas(64) LockedHeap
+    {
+        std::mutex lock;
+        MemoryAllocator heap;
+
+        // Remote-free queue: producers push with a CAS on remoteHead, the
+        // consumer takes the whole list with one exchange (so there is no
+        // ABA problem). Blocks are linked through the first word of their
+        // payload, which the owner gave up when it freed the block.
+        alignas(64) std::atomic<MemoryBlock *> remoteHead{nullptr};
+
+        // Remote-free counters (written with atomic adds from any thread)
+        std::atomic<size_t> remoteFrees{0};
+        std::atomic<size_t> remoteBytes{0};
+        std::atomic<size_t> remoteDrains{0};
+        std::atomic<size_t> remoteDrained{0};
+        std::atomic<size_t> drainNanos{0};
+        std::atomic<size_t> maxDrainNanos{0};
+
+        size_t publishedArenas = 0; // Arenas already in the range list (under the lock)
+
+        LockedHeap(AllocationStrategy strat, const HeapConfig &config)
+            : heap(strat, config)
+        {
+            heap.SetVerbose(false);
+        }
+    };
+
+    // Address range of one arena's block headers, in the lock-free range
+    // list. Nodes are immutable once published and live as long as the
+    // allocator
+    struct ArenaRange
+    {
+        const char *begin;
+        const char *end;
+        size_t heap;       // Index of the owning arena in heaps
+        ArenaRange *next;
+    };
+
+    // Per-thread cache of freed blocks. Only the owning thread touches the
+    // bins; the counters are written by the owner and read by GetStats
+    struct alignas(64) ThreadCache
+    {
+        size_t homeHeap;                                   // Arena this thread allocates from
+        MemoryBlock *bins[CACHE_NUM_CLASSES][CACHE_MAX_DEPTH]; // Cached blocks per class
+        size_t counts[CACHE_NUM_CLASSES];                  // Blocks in each class
+
+        std::atomic<size_t> hits{0};
+        std::atomic<size_t> misses{0};
+        std::atomic<size_t> flushes{0};
+        std::atomic<size_t> cachedBlocks{0};
+        std::atomic<size_t> cachedBytes{0};
+
+        explicit ThreadCache(size_t home)
+            : homeHeap(home)
+        {
+            std::fill(std::begin(counts), std::end(counts), 0);
+        }
+    };
+
+    std::vector<std::unique_ptr<LockedHeap>> heaps; // The independent arenas
+    size_t cacheDepth;                              // Blocks kept per class (0 = no caches)
+    uint64_t instanceId;                            // Tells allocators apart in thread-local lookups
+    std::atomic<size_t> nextHeap;                   // Round-robin arena assignment
+    std::atomic<bool> verbose;                      // Print invalid frees to std::cout
+
+    std::mutex registryLock;                          // Guards caches
+    std::vector<std::unique_ptr<ThreadCache>> caches; // Every thread's cache, owned here
+
+    std::atomic<ArenaRange *> ranges{nullptr};           // Published arena ranges, newest first
+    std::mutex rangeLock;                                // Guards rangeNodes
+    std::vector<std::unique_ptr<ArenaRange>> rangeNodes; // Owns the nodes of the range list
+
+public:
+    /**
+     * Constructor - Create the arenas
+     *
+     * @param numHeaps - Number of independent arenas (at least 1)
+     * @param strat - Allocation strategy of every arena
+     * @param config - Heap layout of every arena; heapId is assigned here
+     * @param depth - Blocks cached per size class and thread (0 disables
+     *                the caches, at most CACHE_MAX_DEPTH)
+     */
+    ConcurrentAllocator(size_t numHeaps,
+                        AllocationStrategy strat = AllocationStrategy::FIRST_FIT,
+                        const HeapConfig &config = HeapConfig(),
+                        size_t depth = CACHE_DEFAULT_DEPTH)
+        : cacheDepth(std::min(depth, CACHE_MAX_DEPTH)), instanceId(NextInstanceId()), nextHeap(0), verbose(true)
+    {
+        numHeaps = std::max<size_t>(1, std::min<size_t>(numHeaps, UINT16_MAX));
+        for (size_t i = 0; i < numHeaps; i++)
+        {
+            HeapConfig arenaConfig = config;
+            arenaConfig.heapId = static_cast<uint16_t>(i);
+            heaps.push_back(std::make_unique<LockedHeap>(strat, arenaConfig));
+            PublishArenas(i);
+        }
+    }
+
+    ConcurrentAllocator(const ConcurrentAllocator &) = delete;
+    ConcurrentAllocator &operator=(const ConcurrentAllocator &) = delete;
+
+    size_t GetArenaCount() const
+    {
+        return heaps.size();
+    }
+
+    /**
+     * Enable or disable error messages
+     *
+     * @param enabled - When false, invalid frees only report through the
+     *                  return value of Deallocate (the arenas themselves
+     *                  never print)
+     */
+    void SetVerbose(bool enabled)
+    {
+        verbose = enabled;
+    }
+
+    /**
+     * Allocate memory (thread-safe)
+     *
+     * @param size - Number of bytes to allocate
+     * @return - Pointer to allocated memory, or nullptr if allocation failed
+     *
+     * Takes a cached block of a large enough class when there is one,
+     * otherwise allocates from the calling thread's arena under its lock.
+     * Pending remote frees of that arena are drained first.
+     */
+    void *Allocate(size_t size)
+    {
+        if (size == 0)
+            return nullptr;
+
+        ThreadCache &cache = GetThreadCache();
+        LockedHeap &arena = *heaps[cache.homeHeap];
+
+        size_t sizeClass = AllocClass(size);
+        if (sizeClass < CACHE_NUM_CLASSES && cache.counts[sizeClass] > 0)
+        {
+            DrainIfPending(arena);
+
+            MemoryBlock *block = cache.bins[sizeClass][--cache.counts[sizeClass]];
+            block->magic = BLOCK_MAGIC;
+            Bump(cache.hits, 1);
+            Bump(cache.cachedBlocks, -1);
+            Bump(cache.cachedBytes, -static_cast<ptrdiff_t>(block->Size()));
+            return block->GetData();
+        }
+
+        Bump(cache.misses, 1);
+        std::lock_guard<std::mutex> guard(arena.lock);
+        DrainRemoteFrees(arena);
+        void *ptr = arena.heap.Allocate(size);
+        PublishArenas(cache.homeHeap);
+        return ptr;
+    }
+
+    /**
+     * Allocate aligned memory (thread-safe)
+     *
+     * @param size - Number of bytes to allocate
+     * @param alignment - Required alignment of the returned pointer (a power of two)
+     * @return - Aligned pointer to allocated memory, or nullptr if allocation failed
+     *
+     * Always served by the calling thread's arena, since cached blocks only
+     * carry the natural alignment. Passing the cache line size keeps
+     * blocks used by different threads off each other's lines. The block
+     * is freed with Deallocate and may then be reused from a cache.
+     */
+    void *AllocateAligned(size_t size, size_t alignment)
+    {
+        ThreadCache &cache = GetThreadCache();
+        LockedHeap &arena = *heaps[cache.homeHeap];
+
+        std::lock_guard<std::mutex> guard(arena.lock);
+        DrainRemoteFrees(arena);
+        void *ptr = arena.heap.AllocateAligned(size, alignment);
+        PublishArenas(cache.homeHeap);
+        return ptr;
+    }
+
+    /**
+     * Deallocate memory (thread-safe)
+     *
+     * @param ptr - Pointer returned by Allocate, from any thread
+     * @return - True if deallocation succeeded, false otherwise
+     *
+     * The owning arena is found from the address, and a pointer outside
+     * every arena is rejected before its header is read. Small blocks are
+     * parked in the calling thread's cache. Everything else goes back to
+     * the owning arena: directly under its lock when the calling thread is
+     * bound to it, through its remote-free queue when not.
+     */
+    bool Deallocate(void *ptr)
+    {
+        if (!ptr)
+            return false;
+
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+
+        size_t owner = FindOwner(block);
+        if (owner == heaps.size() || block->magic == CACHED_MAGIC || block->magic == REMOTE_MAGIC)
+        {
+            if (verbose)
+                std::cout << "ERROR: Invalid deallocation request.\n";
+            return false;
+        }
+
+        ThreadCache &cache = GetThreadCache();
+        DrainIfPending(*heaps[cache.homeHeap]);
+
+        if (COMPACT_HEADERS)
+        {
+            return ReturnToHeap(cache, block, owner);
+        }
+
+        // Only a well-formed allocated header may enter the cache; anything
+        // else is left for the owning heap to validate and reject
+        size_t sizeClass = FreeClass(block->Size());
+        if (cacheDepth > 0 && block->magic == BLOCK_MAGIC && block->IsAllocated() &&
+            block->heapId == owner && sizeClass < CACHE_NUM_CLASSES)
+        {
+            if (cache.counts[sizeClass] == cacheDepth)
+            {
+                FlushClass(cache, sizeClass, cacheDepth / 2);
+            }
+
+            block->magic = CACHED_MAGIC;
+            cache.bins[sizeClass][cache.counts[sizeClass]++] = block;
+            Bump(cache.cachedBlocks, 1);
+            Bump(cache.cachedBytes, static_cast<ptrdiff_t>(block->Size()));
+            return true;
+        }
+
+        return ReturnToHeap(cache, block, owner);
+    }
+
+    /**
+     * Return every block in the calling thread's cache to its heap
+     */
+    void FlushThreadCache()
+    {
+        ThreadCache &cache = GetThreadCache();
+        for (size_t i = 0; i < CACHE_NUM_CLASSES; i++)
+        {
+            FlushClass(cache, i, cache.counts[i]);
+        }
+    }
+
+    /**
+     * Return every cached block of every thread to its heap, and drain
+     * every remote-free queue
+     *
+     * Only safe while no other thread is using the allocator (e.g. after
+     * the worker threads have been joined).
+     */
+    void FlushAllCaches()
+    {
+        {
+            std::lock_guard<std::mutex> guard(registryLock);
+            for (auto &cache : caches)
+            {
+                for (size_t i = 0; i < CACHE_NUM_CLASSES; i++)
+                {
+                    FlushClass(*cache, i, cache->counts[i]);
+                }
+            }
+        }
+        DrainAllRemoteFrees();
+    }
+
+    /**
+     * Drain the remote-free queue of every arena (thread-safe)
+     *
+     * Queues are normally drained by the threads bound to each arena; this
+     * covers arenas whose threads have exited.
+     */
+    void DrainAllRemoteFrees()
+    {
+        for (auto &arena : heaps)
+        {
+            std::lock_guard<std::mutex> guard(arena->lock);
+            DrainRemoteFrees(*arena);
+        }
+    }
+
+    /**
+     * Get a snapshot of the combined statistics
+     *
+     * @return - Arena statistics summed under each arena's lock, and the
+     *           cache counters (which may be a few operations stale)
+     */
+    ConcurrentStats GetStats()
+    {
+        ConcurrentStats stats{};
+        stats.arenas = heaps.size();
+
+        for (auto &arena : heaps)
+        {
+            std::lock_guard<std::mutex> guard(arena->lock);
+            MemoryStats s = arena->heap.GetStats();
+            stats.heap.totalMemory += s.totalMemory;
+            stats.heap.totalAllocated += s.totalAllocated;
+            stats.heap.totalFree += s.totalFree;
+            stats.heap.allocatedBlocks += s.allocatedBlocks;
+            stats.heap.freeBlocks += s.freeBlocks;
+            stats.heap.largestFreeBlock = std::max(stats.heap.largestFreeBlock, s.largestFreeBlock);
+            stats.heap.internalFragmentation += s.internalFragmentation;
+            stats.heap.headerBytes += s.headerBytes;
+            stats.heap.usableBytes += s.usableBytes;
+            stats.heap.searches += s.searches;
+            stats.heap.blocksVisited += s.blocksVisited;
+
+            size_t drained = arena->remoteDrained.load(std::memory_order_relaxed);
+            stats.remoteFrees += arena->remoteFrees.load(std::memory_order_relaxed);
+            stats.remoteBytes += arena->remoteBytes.load(std::memory_order_relaxed);
+            stats.remoteDrains += arena->remoteDrains.load(std::memory_order_relaxed);
+            stats.remotePending += arena->remoteFrees.load(std::memory_order_relaxed) - drained;
+            stats.drainNanos += arena->drainNanos.load(std::memory_order_relaxed);
+            stats.maxDrainNanos = std::max(stats.maxDrainNanos, arena->maxDrainNanos.load(std::memory_order_relaxed));
+        }
+        stats.heap.fragmentation = stats.heap.totalFree > 0
+                                       ? 1.0 - static_cast<double>(stats.heap.largestFreeBlock) / stats.heap.totalFree
+                                       : 0.0;
+
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (auto &cache : caches)
+        {
+            stats.cacheHits += cache->hits.load(std::memory_order_relaxed);
+            stats.cacheMisses += cache->misses.load(std::memory_order_relaxed);
+            stats.cacheFlushes += cache->flushes.load(std::memory_order_relaxed);
+            stats.cachedBlocks += cache->cachedBlocks.load(std::memory_order_relaxed);
+            stats.cachedBytes += cache->cachedBytes.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    static uint64_t NextInstanceId()
+    {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    // Counters have a single writer, so a relaxed load/store pair is enough
+    static void Bump(std::atomic<size_t> &counter, ptrdiff_t delta)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    // Smallest class whose blocks are all large enough for the request
+    static size_t AllocClass(size_t size)
+    {
+        size = AlignUp(std::max(size, MIN_BLOCK_SIZE));
+        return CeilLog2(size) - CACHE_MIN_SHIFT;
+    }
+
+    // Class of a freed block: every block in class k has at least 2^(k+4) bytes
+    static size_t FreeClass(size_t blockSize)
+    {
+        return FloorLog2(blockSize) - CACHE_MIN_SHIFT;
+    }
+
+    /**
+     * Find (or create) the calling thread's cache for this allocator
+     *
+     * Each thread keeps a short list of (allocator id, cache) pairs, so
+     * several allocators can be used from the same thread. Ids are never
+     * reused, so entries of destroyed allocators are simply never matched.
+     */
+    ThreadCache &GetThreadCache()
+    {
+        thread_local std::vector<std::pair<uint64_t, ThreadCache *>> threadCaches;
+
+        for (auto &entry : threadCaches)
+        {
+            if (entry.first == instanceId)
+            {
+                return *entry.second;
+            }
+        }
+
+        size_t home = nextHeap.fetch_add(1, std::memory_order_relaxed) % heaps.size();
+        std::lock_guard<std::mutex> guard(registryLock);
+        caches.push_back(std::make_unique<ThreadCache>(home));
+        threadCaches.emplace_back(instanceId, caches.back().get());
+        return *caches.back();
+    }
+
+    /**
+     * Add the arenas a heap has grown since the last call to the range list
+     *
+     * The caller holds the arena's lock (or is the constructor). A heap
+     * keeps its arenas in address order, so new ones are found by looking
+     * each range up among the published ones.
+     */
+    void PublishArenas(size_t index)
+    {
+        LockedHeap &arena = *heaps[index];
+        if (arena.heap.GetArenaCount() == arena.publishedArenas)
+            return;
+
+        std::lock_guard<std::mutex> guard(rangeLock);
+        arena.heap.ForEachArena([&](const char *begin, const char *end) {
+            for (ArenaRange *range = ranges.load(std::memory_order_relaxed); range; range = range->next)
+            {
+                if (range->begin == begin)
+                    return;
+            }
+            rangeNodes.push_back(std::make_unique<ArenaRange>(
+                ArenaRange{begin, end, index, ranges.load(std::memory_order_relaxed)}));
+            ranges.store(rangeNodes.back().get(), std::memory_order_release);
+        });
+        arena.publishedArenas = arena.heap.GetArenaCount();
+    }
+
+    // Arena whose heap holds a block header address, or heaps.size()
+    size_t FindOwner(const MemoryBlock *block) const
+    {
+        const char *address = reinterpret_cast<const char *>(block);
+        for (ArenaRange *range = ranges.load(std::memory_order_acquire); range; range = range->next)
+        {
+            if (address >= range->begin && address < range->end)
+            {
+                return range->heap;
+            }
+        }
+        return heaps.size();
+    }
+
+    // Hand a block back to the arena that owns it, through its remote-free
+    // queue when the calling thread is bound to a different arena (compact
+    // headers always take the owner's lock, see the class comment)
+    bool ReturnToHeap(ThreadCache &cache, MemoryBlock *block, size_t owner)
+    {
+        if (!COMPACT_HEADERS && owner != cache.homeHeap && block->magic == BLOCK_MAGIC &&
+            block->heapId == owner && block->IsAllocated())
+        {
+            PushRemoteFree(*heaps[owner], block);
+            return true;
+        }
+
+        LockedHeap &arena = *heaps[owner];
+        std::lock_guard<std::mutex> guard(arena.lock);
+        if (!arena.heap.Deallocate(block->GetData()))
+        {
+            if (verbose)
+                std::cout << "ERROR: Invalid deallocation request.\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Push a block onto an arena's remote-free queue (lock-free, any thread)
+    static void PushRemoteFree(LockedHeap &arena, MemoryBlock *block)
+    {
+        block->magic = REMOTE_MAGIC;
+        arena.remoteFrees.fetch_add(1, std::memory_order_relaxed);
+        arena.remoteBytes.fetch_add(block->Size(), std::memory_order_relaxed);
+
+        MemoryBlock *head = arena.remoteHead.load(std::memory_order_relaxed);
+        do
+        {
+            *static_cast<MemoryBlock **>(block->GetData()) = head;
+        } while (!arena.remoteHead.compare_exchange_weak(head, block,
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed));
+    }
+
+    // Drain an arena's queue only if something is waiting, so the fast
+    // paths pay a single relaxed load when there are no remote frees
+    static void DrainIfPending(LockedHeap &arena)
+    {
+        if (arena.remoteHead.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> guard(arena.lock);
+            DrainRemoteFrees(arena);
+        }
+    }
+
+    /**
+     * Free every block waiting in an arena's remote-free queue
+     *
+     * The caller holds the arena's lock. The whole queue is taken in one
+     * exchange and each block goes through the normal Deallocate path, so
+     * it coalesces with its neighbours (or its buddy) as usual.
+     */
+    static void DrainRemoteFrees(LockedHeap &arena)
+    {
+        MemoryBlock *block = arena.remoteHead.exchange(nullptr, std::memory_order_acquire);
+        if (!block)
+            return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        size_t count = 0;
+        while (block)
+        {
+            MemoryBlock *next = *static_cast<MemoryBlock **>(block->GetData());
+            block->magic = BLOCK_MAGIC;
+            arena.heap.Deallocate(block->GetData());
+            block = next;
+            count++;
+        }
+
+        size_t nanos = static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                               std::chrono::steady_clock::now() - start)
+                                               .count());
+        arena.remoteDrains.fetch_add(1, std::memory_order_relaxed);
+        arena.remoteDrained.fetch_add(count, std::memory_order_relaxed);
+        arena.drainNanos.fetch_add(nanos, std::memory_order_relaxed);
+        if (nanos > arena.maxDrainNanos.load(std::memory_order_relaxed))
+        {
+            arena.maxDrainNanos.store(nanos, std::memory_order_relaxed);
+        }
+    }
+
+    // Return the newest `count` blocks of one class to their heaps. Blocks
+    // of the thread's own arena are freed under one lock acquisition, the
+    // others go onto their owners' remote-free queues
+    void FlushClass(ThreadCache &cache, size_t sizeClass, size_t count)
+    {
+        std::unique_lock<std::mutex> held;
+        LockedHeap &home = *heaps[cache.homeHeap];
+        size_t bytes = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            MemoryBlock *block = cache.bins[sizeClass][--cache.counts[sizeClass]];
+            bytes += block->Size();
+            block->magic = BLOCK_MAGIC;
+
+            if (block->heapId != cache.homeHeap)
+            {
+                PushRemoteFree(*heaps[block->heapId], block);
+                continue;
+            }
+
+            if (!held.owns_lock())
+            {
+                held = std::unique_lock<std::mutex>(home.lock);
+            }
+            home.heap.Deallocate(block->GetData());
+        }
+
+        Bump(cache.flushes, static_cast<ptrdiff_t>(count));
+        Bump(cache.cachedBlocks, -static_cast<ptrdiff_t>(count));
+        Bump(cache.cachedBytes, -static_cast<ptrdiff_t>(bytes));
+    }
+};
+
+#endif // CONCURRENT_ALLOCATOR_H
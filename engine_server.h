@@ -0,0 +1,192 @@
+/**
+ * ============================================================================
+ * ENGINE SERVER - Pipe Protocol for the Web Front-End
+ * ============================================================================
+ *
+ * Runs the allocator as a long-lived engine process: commands arrive one
+ * per line on stdin and every command gets exactly one line of JSON back
+ * on stdout, so server.js can map each HTTP request to one round trip.
+ *
+ * Commands:
+ *   a <size>       Allocate  -> {"address":A,"size":S} or {"error":...}
+ *   f <address>    Free the allocation at block address A -> {"success":true}
+ *   s              Statistics of the heap
+ *   b              Every block as [{"address":A,"size":S,"allocated":B},...]
+ *   t <strategy>   Switch strategy (first, best, tree, buddy, next, worst)
+ *   r              Free every allocation
+ *
+ * Addresses are block header offsets in the virtual heap (see
+ * MemoryAllocator::ForEachBlock), sizes are block sizes (rounded up from
+ * the request, header excluded), as `b` reports them.
+ * ============================================================================
+ */
+
+#ifndef ENGINE_SERVER_H
+#define ENGINE_SERVER_H
+
+#include "memory_allocator.h"
+#include "trace_replay.h"
+
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+
+// Line-protocol engine
+/**
+ * EngineServer Class
+ *
+ * Owns the mapping from the addresses handed to clients to the engine's
+ * pointers; the heap itself stays the single source of truth for blocks
+ * and statistics.
+ */
+class EngineServer
+{
+private:
+    MemoryAllocator &heap;                    // Heap serving every request
+    std::unordered_map<size_t, void *> live;  // Live allocations by block address
+
+public:
+    explicit EngineServer(MemoryAllocator &engineHeap)
+        : heap(engineHeap)
+    {
+    }
+
+    EngineServer(const EngineServer &) = delete;
+    EngineServer &operator=(const EngineServer &) = delete;
+
+    /**
+     * Serve commands until the input ends
+     *
+     * @param in - Command stream (the pipe from the web server)
+     * @param out - Response stream; flushed after every response
+     */
+    void Run(std::istream &in, std::ostream &out)
+    {
+        heap.SetVerbose(false);
+        out << std::setprecision(6) << std::defaultfloat;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            Apply(line.c_str(), out);
+            out << "\n";
+            out.flush();
+        }
+    }
+
+private:
+    // Run one command and write its response (without the newline)
+    void Apply(const char *cursor, std::ostream &out)
+    {
+        char op = *cursor++;
+        uint64_t value = 0;
+
+        switch (op)
+        {
+        case 'a':
+        {
+            bool valid = ParseTraceField(cursor, value) && AtTraceLineEnd(cursor) && value > 0;
+            void *ptr = valid ? heap.Allocate(value) : nullptr;
+            if (!ptr)
+            {
+                out << (valid ? "{\"error\":\"Not enough memory\"}" : "{\"error\":\"Invalid size\"}");
+                return;
+            }
+
+            size_t address = heap.BlockOffset(ptr);
+            live.emplace(address, ptr);
+            out << "{\"address\":" << address << ",\"size\":" << heap.GetBlockSize(ptr) << "}";
+            return;
+        }
+
+        case 'f':
+        {
+            auto it = ParseTraceField(cursor, value) && AtTraceLineEnd(cursor) ? live.find(value) : live.end();
+            if (it == live.end() || !heap.Deallocate(it->second))
+            {
+                out << "{\"error\":\"Invalid deallocation\"}";
+                return;
+            }
+
+            live.erase(it);
+            out << "{\"success\":true}";
+            return;
+        }
+
+        case 's':
+        {
+            MemoryStats stats = heap.GetStats();
+            out << "{\"strategy\":\"" << StrategyKey(heap.GetStrategy()) << "\""
+                << ",\"totalMemory\":" << stats.totalMemory
+                << ",\"totalAllocated\":" << stats.totalAllocated
+                << ",\"totalFree\":" << stats.totalFree
+                << ",\"allocatedBlocks\":" << stats.allocatedBlocks
+                << ",\"freeBlocks\":" << stats.freeBlocks
+                << ",\"largestFreeBlock\":" << stats.largestFreeBlock
+                << ",\"fragmentation\":" << stats.fragmentation
+                << ",\"internalFragmentation\":" << stats.internalFragmentation
+                << ",\"headerBytes\":" << stats.headerBytes
+                << ",\"usableBytes\":" << stats.usableBytes << "}";
+            return;
+        }
+
+        case 'b':
+        {
+            bool first = true;
+            out << "[";
+            heap.ForEachBlock([&](size_t address, size_t size, bool allocated) {
+                out << (first ? "" : ",") << "{\"address\":" << address << ",\"size\":" << size
+                    << ",\"allocated\":" << (allocated ? "true" : "false") << "}";
+                first = false;
+            });
+            out << "]";
+            return;
+        }
+
+        case 't':
+        {
+            while (*cursor == ' ' || *cursor == '\t')
+            {
+                cursor++;
+            }
+            std::string key = cursor;
+            while (!key.empty() && (key.back() == ' ' || key.back() == '\r'))
+            {
+                key.pop_back();
+            }
+
+            AllocationStrategy strategy;
+            if (!ParseStrategy(key, strategy))
+            {
+                out << "{\"error\":\"Invalid strategy\"}";
+            }
+            else if (!heap.SetStrategy(strategy))
+            {
+                out << "{\"error\":\"Free all blocks before switching to or from Buddy allocation\"}";
+            }
+            else
+            {
+                out << "{\"success\":true}";
+            }
+            return;
+        }
+
+        case 'r':
+        {
+            for (auto &entry : live)
+            {
+                heap.Deallocate(entry.second);
+            }
+            live.clear();
+            out << "{\"success\":true}";
+            return;
+        }
+
+        default:
+            out << "{\"error\":\"Unknown command\"}";
+            return;
+        }
+    }
+};
+
+#endif // ENGINE_SERVER_H
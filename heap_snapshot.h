@@ -0,0 +1,170 @@
+/**
+ * ============================================================================
+ * HEAP SNAPSHOT - Binary Layout Export
+ * ============================================================================
+ *
+ * Captures the block layout of a heap in a compact binary form for
+ * visualisers and offline analysis: a fixed header, an optional block
+ * table and a density map at a resolution chosen by the caller. Records
+ * are copied as they are, so a heap with millions of blocks is exported
+ * in one pass without any text formatting.
+ *
+ * Layout (native byte order, little-endian on all supported targets):
+ *   SnapshotHeader
+ *   SnapshotBlock[header.blockCount]   Blocks in address order
+ *   uint8_t[header.buckets]            Allocated share of each bucket,
+ *                                      0 = all free .. 255 = all allocated
+ * ============================================================================
+ */
+
+#ifndef HEAP_SNAPSHOT_H
+#define HEAP_SNAPSHOT_H
+
+#include "memory_allocator.h"
+
+#include <fstream>
+
+constexpr char SNAPSHOT_MAGIC[8] = {'H', 'E', 'A', 'P', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint64_t SNAPSHOT_ALLOCATED = 1; // State bit of SnapshotBlock::sizeAndState
+constexpr size_t SNAPSHOT_RESOLUTION = 4096; // Default number of density buckets
+
+// Snapshot file header
+/**
+ * SnapshotHeader Structure
+ *
+ * Members:
+ *   - magic/version: SNAPSHOT_MAGIC and SNAPSHOT_VERSION
+ *   - strategy: AllocationStrategy of the heap
+ *   - heapBytes: Size of the virtual heap (all arenas back to back)
+ *   - blockCount: Entries in the block table (0 when it was left out)
+ *   - buckets/bucketBytes: Entries in the density map / heap bytes each
+ *                          one covers (the last may cover fewer)
+ *   - totalAllocated/totalFree/largestFreeBlock: Heap statistics at the
+ *     time of the snapshot
+ */
+struct SnapshotHeader
+{
+    char magic[8];             // SNAPSHOT_MAGIC
+    uint32_t version;          // SNAPSHOT_VERSION
+    uint32_t strategy;         // AllocationStrategy of the heap
+    uint64_t heapBytes;        // Size of the virtual heap
+    uint64_t blockCount;       // Entries in the block table
+    uint64_t buckets;          // Entries in the density map
+    uint64_t bucketBytes;      // Heap bytes per density entry
+    uint64_t totalAllocated;   // Bytes allocated
+    uint64_t totalFree;        // Bytes free
+    uint64_t largestFreeBlock; // Largest free block
+};
+
+// Block table entry
+/**
+ * SnapshotBlock Structure
+ *
+ * One block: the offset of its header in the virtual heap and its size
+ * (excluding the header). Sizes are multiples of the alignment, so the
+ * lowest bit is free to carry the state (SNAPSHOT_ALLOCATED).
+ */
+struct SnapshotBlock
+{
+    uint64_t offset;       // Header offset in the virtual heap
+    uint64_t sizeAndState; // Size | SNAPSHOT_ALLOCATED when allocated
+};
+
+// Snapshot capture
+/**
+ * Capture a snapshot of a heap into a buffer
+ *
+ * @param heap - Any BasicMemoryAllocator
+ * @param buffer - Receives the snapshot (replacing its contents)
+ * @param resolution - Number of density buckets (at most one per byte)
+ * @param includeBlocks - Whether to write the block table; without it the
+ *                        snapshot is only the header and the density map
+ *
+ * One walk over the blocks fills both the table and the density map; an
+ * allocated block (header included) adds its bytes to every bucket it
+ * overlaps, so the cost is O(blocks + buckets).
+ */
+template <typename Heap>
+void CaptureHeapSnapshot(const Heap &heap, std::vector<uint8_t> &buffer,
+                         size_t resolution = SNAPSHOT_RESOLUTION, bool includeBlocks = true)
+{
+    MemoryStats stats = heap.GetStats();
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.strategy = static_cast<uint32_t>(heap.GetStrategy());
+    header.heapBytes = stats.totalMemory;
+    header.bucketBytes = (stats.totalMemory + std::max<size_t>(resolution, 1) - 1) / std::max<size_t>(resolution, 1);
+    header.buckets = (stats.totalMemory + header.bucketBytes - 1) / header.bucketBytes;
+    header.totalAllocated = stats.totalAllocated;
+    header.totalFree = stats.totalFree;
+    header.largestFreeBlock = stats.largestFreeBlock;
+
+    size_t blockCount = includeBlocks ? stats.allocatedBlocks + stats.freeBlocks : 0;
+    buffer.clear();
+    buffer.reserve(sizeof(SnapshotHeader) + blockCount * sizeof(SnapshotBlock) + header.buckets);
+    buffer.resize(sizeof(SnapshotHeader));
+
+    std::vector<uint64_t> allocatedBytes(header.buckets, 0);
+    heap.ForEachBlock([&](size_t offset, size_t size, bool allocated) {
+        if (includeBlocks)
+        {
+            SnapshotBlock entry = {offset, size | (allocated ? SNAPSHOT_ALLOCATED : 0)};
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&entry);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(entry));
+            header.blockCount++;
+        }
+
+        if (!allocated)
+            return;
+
+        // Spread the block's bytes over the buckets it overlaps
+        size_t begin = offset;
+        size_t end = offset + HEADER_SIZE + size;
+        while (begin < end)
+        {
+            size_t bucket = begin / header.bucketBytes;
+            size_t bucketEnd = std::min(end, (bucket + 1) * header.bucketBytes);
+            allocatedBytes[bucket] += bucketEnd - begin;
+            begin = bucketEnd;
+        }
+    });
+
+    for (size_t i = 0; i < header.buckets; i++)
+    {
+        uint64_t bucketSize = std::min<uint64_t>(header.bucketBytes, header.heapBytes - i * header.bucketBytes);
+        buffer.push_back(static_cast<uint8_t>((allocatedBytes[i] * 255 + bucketSize / 2) / bucketSize));
+    }
+
+    std::memcpy(buffer.data(), &header, sizeof(header));
+}
+
+/**
+ * Write a snapshot of a heap to a file
+ *
+ * @param heap - Any BasicMemoryAllocator
+ * @param path - Output file (overwritten)
+ * @param resolution - Number of density buckets
+ * @param includeBlocks - Whether to write the block table
+ * @return - True if the whole snapshot was written
+ */
+template <typename Heap>
+bool SaveHeapSnapshot(const Heap &heap, const std::string &path,
+                      size_t resolution = SNAPSHOT_RESOLUTION, bool includeBlocks = true)
+{
+    std::vector<uint8_t> buffer;
+    CaptureHeapSnapshot(heap, buffer, resolution, includeBlocks);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "ERROR: Cannot open snapshot file " << path << "\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    return static_cast<bool>(file);
+}
+
+#endif // HEAP_SNAPSHOT_H
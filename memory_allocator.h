@@ -0,0 +1,4347 @@
+/**
+ * ============================================================================
+ * MEMORY ALLOCATOR - Core Engine
+ * ============================================================================
+ *
+ * The virtual heap shared by the interactive simulator and the benchmarks:
+ * block layout, allocation strategies, heap arenas and statistics.
+ * Header-only; include it from any tool that needs an allocator.
+ * ============================================================================
+ */
+
+#ifndef MEMORY_ALLOCATOR_H
+#define MEMORY_ALLOCATOR_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <cstring>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <cstdlib>
+#include <unordered_map>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#endif
+
+// Free-block index scans compare 8 sizes per instruction with AVX2 (e.g.
+// -mavx2 or cmake -DALLOCATOR_AVX2=ON), 4 with SSE2 (every x86-64 build),
+// and one at a time elsewhere
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// Constants
+constexpr size_t MEMORY_SIZE = 1024 * 1024; // Default virtual heap size (1MB)
+constexpr size_t HEAP_PAGE_SIZE = 4096;     // Arena sizes are rounded to whole pages
+constexpr size_t MIN_BLOCK_SIZE = 16;       // Minimum block size (bytes)
+constexpr size_t ALIGNMENT = 16;            // Alignment of every block and payload
+constexpr size_t NUM_SIZE_CLASSES = 64;     // One free-list bin per power of two
+
+// Hot-path instrumentation (latency histograms and event counters) is
+// compiled in only when ALLOCATOR_INSTRUMENTATION is defined to 1, e.g.
+// with cmake -DALLOCATOR_INSTRUMENTATION=ON; otherwise it costs nothing
+#ifndef ALLOCATOR_INSTRUMENTATION
+#define ALLOCATOR_INSTRUMENTATION 0
+#endif
+constexpr bool INSTRUMENTATION_ENABLED = ALLOCATOR_INSTRUMENTATION != 0;
+
+// Compact 8-byte block headers (see MemoryBlock) are selected when
+// ALLOCATOR_COMPACT_HEADERS is defined to 1, e.g. with
+// cmake -DALLOCATOR_COMPACT_HEADERS=ON; the default is the full header
+#ifndef ALLOCATOR_COMPACT_HEADERS
+#define ALLOCATOR_COMPACT_HEADERS 0
+#endif
+constexpr bool COMPACT_HEADERS = ALLOCATOR_COMPACT_HEADERS != 0;
+
+// Canary stamped into every live header (16 bits in the compact header)
+#if ALLOCATOR_COMPACT_HEADERS
+typedef uint16_t BlockMagic;
+constexpr BlockMagic BLOCK_MAGIC = 0xB10C;
+#else
+typedef uint32_t BlockMagic;
+constexpr BlockMagic BLOCK_MAGIC = 0xB10CB10C;
+#endif
+
+// Round a size up to the next multiple of ALIGNMENT
+constexpr size_t AlignUp(size_t size)
+{
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+// Smallest k with 2^k >= value, for compile-time constants
+constexpr size_t CeilLog2(size_t value)
+{
+    size_t log = 0;
+    while ((size_t(1) << log) < value)
+        log++;
+    return log;
+}
+
+// Index of the highest set bit (floor of log2), used to pick a size class
+inline size_t FloorLog2(size_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(63 - __builtin_clzll(static_cast<unsigned long long>(value)));
+#else
+    size_t log = 0;
+    while (value >>= 1)
+        log++;
+    return log;
+#endif
+}
+
+// Allocation strategies
+/**
+ * AllocationStrategy Enum
+ *
+ * FIRST_FIT: Allocates the first block that can accommodate the requested size.
+ *            Simple and fast, but can lead to fragmentation.
+ *
+ * BEST_FIT: Finds the smallest block that can accommodate the requested size.
+ *           Reduces wasted space but is slower and can create many small fragments.
+ *
+ * TREE_BEST_FIT: Same choice as BEST_FIT, but found in O(log n) through a
+ *                treap of free blocks ordered by (size, address).
+ *
+ * BUDDY: Binary buddy system. Blocks are power-of-two sized and aligned, so a
+ *        block's buddy is found by flipping one address bit. Allocation and
+ *        free take at most one split/merge per order, but rounding requests
+ *        up to a power of two causes internal fragmentation.
+ *
+ * NEXT_FIT: Like FIRST_FIT, but each search starts where the previous one
+ *           ended and wraps around, spreading allocations over the heap.
+ *
+ * WORST_FIT: Splits the largest free block, so the leftover stays large
+ *            enough to be useful. Tends to use up big blocks quickly.
+ */
+enum class AllocationStrategy
+{
+    FIRST_FIT,     // Use first available block
+    BEST_FIT,      // Use smallest suitable block
+    TREE_BEST_FIT, // Use smallest suitable block, found through the size tree
+    BUDDY,         // Use a power-of-two block from the buddy free lists
+    NEXT_FIT,      // Use first available block after the previous allocation
+    WORST_FIT      // Use largest available block
+};
+
+// Every strategy, in menu order
+constexpr AllocationStrategy ALL_STRATEGIES[] = {
+    AllocationStrategy::FIRST_FIT,
+    AllocationStrategy::BEST_FIT,
+    AllocationStrategy::TREE_BEST_FIT,
+    AllocationStrategy::BUDDY,
+    AllocationStrategy::NEXT_FIT,
+    AllocationStrategy::WORST_FIT};
+
+// Human-readable name of an allocation strategy
+inline const char *StrategyName(AllocationStrategy strategy)
+{
+    switch (strategy)
+    {
+    case AllocationStrategy::FIRST_FIT:
+        return "First Fit";
+    case AllocationStrategy::BEST_FIT:
+        return "Best Fit";
+    case AllocationStrategy::TREE_BEST_FIT:
+        return "Tree Best Fit";
+    case AllocationStrategy::BUDDY:
+        return "Buddy";
+    case AllocationStrategy::NEXT_FIT:
+        return "Next Fit";
+    case AllocationStrategy::WORST_FIT:
+        return "Worst Fit";
+    }
+    return "Unknown";
+}
+
+// Short command-line name of an allocation strategy
+inline const char *StrategyKey(AllocationStrategy strategy)
+{
+    switch (strategy)
+    {
+    case AllocationStrategy::FIRST_FIT:
+        return "first";
+    case AllocationStrategy::BEST_FIT:
+        return "best";
+    case AllocationStrategy::TREE_BEST_FIT:
+        return "tree";
+    case AllocationStrategy::BUDDY:
+        return "buddy";
+    case AllocationStrategy::NEXT_FIT:
+        return "next";
+    case AllocationStrategy::WORST_FIT:
+        return "worst";
+    }
+    return "unknown";
+}
+
+// Parse a strategy name such as "first" or "buddy"
+/**
+ * Strategy Parsing
+ *
+ * @param text - One of first, best, tree, buddy, next or worst (see StrategyKey)
+ * @param strategy - Receives the matching strategy
+ * @return - True if the name was recognised
+ */
+inline bool ParseStrategy(const std::string &text, AllocationStrategy &strategy)
+{
+    for (AllocationStrategy candidate : ALL_STRATEGIES)
+    {
+        if (text == StrategyKey(candidate))
+        {
+            strategy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Free-block links, kept in the header (full layout) or in the free payload
+// (compact layout)
+enum BlockLink
+{
+    LINK_NEXT_FREE,  // Next free block in the same size-class bin
+    LINK_PREV_FREE,  // Previous free block in the same size-class bin
+    LINK_TREE_LEFT,  // Free blocks ordered before this one by (size, address)
+    LINK_TREE_RIGHT, // Free blocks ordered after this one by (size, address)
+    LINK_COUNT
+};
+
+#if !ALLOCATOR_COMPACT_HEADERS
+
+// Memory block structure
+/**
+ * MemoryBlock Structure
+ *
+ * Represents a block of memory (allocated or free) in the virtual heap.
+ * Blocks are laid out back to back, so neighbours are found by address
+ * arithmetic: forward through this block's size, backward through the
+ * boundary tag (prevSize) holding the size of the block just before it.
+ * A zero-sized, permanently allocated end marker terminates the heap.
+ * The engine goes through the accessors only, so the compact layout
+ * below can replace this one at build time.
+ *
+ * Members:
+ *   - size: Size of the block in bytes (excluding header)
+ *   - prevSize: Size of the physically previous block (0 for the first block)
+ *   - magic: BLOCK_MAGIC while the header is live, cleared when it is merged away
+ *   - allocated: Flag indicating if block is in use
+ *   - heapId: Tag of the heap that owns the block (see HeapConfig::heapId)
+ *   - requestedSize: Bytes the caller asked for (only meaningful while allocated)
+ *   - links: Size-class free-list and treap links, indexed by BlockLink,
+ *            as plain addresses (a heap file reopened at another address
+ *            has them shifted once, see ShiftLinks); only meaningful
+ *            while the block is free
+ */
+struct alignas(ALIGNMENT) MemoryBlock
+{
+    size_t size;           // Size of the block in bytes (excluding header)
+    size_t prevSize;       // Boundary tag: size of the physically previous block
+    BlockMagic magic;      // BLOCK_MAGIC for a live header
+    bool allocated;        // Whether the block is allocated or free
+    uint16_t heapId;       // Tag of the owning heap
+    size_t requestedSize;  // Bytes requested by the caller, before rounding
+    uintptr_t links[LINK_COUNT]; // Free-list and treap links (0 = none)
+
+    // Get pointer to the data area of this block
+    // This moves the pointer past the header to actual usable memory
+    void *GetData()
+    {
+        return reinterpret_cast<void *>(reinterpret_cast<char *>(this) + sizeof(MemoryBlock));
+    }
+
+    size_t Size() const { return size; }
+    void SetSize(size_t bytes) { size = bytes; }
+    bool IsAllocated() const { return allocated; }
+    void SetAllocated(bool state) { allocated = state; }
+    size_t RequestedSize() const { return requestedSize; }
+    void SetRequestedSize(size_t bytes) { requestedSize = bytes; }
+
+    // Fresh header state: the caller stamps the boundary tags around it
+    void Reset(size_t bytes, bool state)
+    {
+        size = bytes;
+        allocated = state;
+    }
+
+    // Mark the block in use (the boundary tag does not record the state)
+    void MarkAllocated()
+    {
+        allocated = true;
+    }
+
+    // Get pointer to the next block based on address arithmetic
+    // This calculates where the next block should be based on current block's size
+    MemoryBlock *GetPhysicalNext()
+    {
+        if (size == 0)
+            return nullptr; // End of memory
+        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(GetData()) + size);
+    }
+
+    // Get pointer to the previous block through the boundary tag
+    // The first block in the heap has no predecessor
+    MemoryBlock *GetPhysicalPrev()
+    {
+        if (prevSize == 0)
+            return nullptr; // Start of memory
+        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(this) - prevSize - sizeof(MemoryBlock));
+    }
+
+    // Opaque boundary tag, saved and restored when a block is moved
+    size_t PrevTag() const { return prevSize; }
+    void SetPrevTag(size_t tag) { prevSize = tag; }
+
+    // Publish this block's size in the next block's boundary tag
+    void StampBoundaryTag()
+    {
+        GetPhysicalNext()->prevSize = size;
+    }
+
+    // Whether the next block's boundary tag agrees with this block
+    bool BoundaryTagMatches()
+    {
+        return GetPhysicalNext()->prevSize == size;
+    }
+
+    // The link base only matters to the compact layout; these links are
+    // plain addresses, so the hot list walks pay no offset arithmetic
+    MemoryBlock *GetLink(BlockLink link, char *) const
+    {
+        return reinterpret_cast<MemoryBlock *>(links[link]);
+    }
+
+    void SetLink(BlockLink link, MemoryBlock *target, char *)
+    {
+        links[link] = reinterpret_cast<uintptr_t>(target);
+    }
+
+    // Move every link of a free block by delta bytes (its heap file was
+    // mapped at another address)
+    void ShiftLinks(uintptr_t delta)
+    {
+        for (uintptr_t &link : links)
+        {
+            if (link)
+            {
+                link += delta;
+            }
+        }
+    }
+
+    // The zero-sized marker placed after the last real block
+    bool IsEndMarker() const
+    {
+        return size == 0;
+    }
+};
+
+#else
+
+constexpr uint32_t BLOCK_IN_USE = 1;    // Flag bit of sizeAndFlags: block is allocated
+constexpr uint32_t BLOCK_PREV_FREE = 2; // Flag bit of sizeAndFlags: previous block is free
+constexpr uint32_t BLOCK_FLAGS = BLOCK_IN_USE | BLOCK_PREV_FREE;
+
+// Memory block structure, compact layout
+/**
+ * MemoryBlock Structure
+ *
+ * The same block as the full layout, in 8 bytes. Sizes are multiples of
+ * 8, which frees the two low bits of the size for the block's own state
+ * and that of its predecessor. Only a free block needs to be found from
+ * its successor, so only a free block carries a boundary tag: a 32-bit
+ * footer in its last payload bytes. The free-list and treap links live
+ * in the free payload too, as 32-bit offsets from the start of the
+ * heap's reservation (0 = none). The requested size is not kept.
+ *
+ * Members:
+ *   - sizeAndFlags: Size in bytes (excluding header) | BLOCK_IN_USE | BLOCK_PREV_FREE
+ *   - magic: BLOCK_MAGIC while the header is live, cleared when it is merged away
+ *   - heapId: Tag of the heap that owns the block (see HeapConfig::heapId)
+ */
+struct MemoryBlock
+{
+    uint32_t sizeAndFlags; // Size | BLOCK_IN_USE | BLOCK_PREV_FREE
+    BlockMagic magic;      // BLOCK_MAGIC for a live header
+    uint16_t heapId;       // Tag of the owning heap
+
+    // Get pointer to the data area of this block
+    void *GetData()
+    {
+        return reinterpret_cast<char *>(this) + sizeof(MemoryBlock);
+    }
+
+    const void *GetData() const
+    {
+        return reinterpret_cast<const char *>(this) + sizeof(MemoryBlock);
+    }
+
+    size_t Size() const { return sizeAndFlags & ~BLOCK_FLAGS; }
+    void SetSize(size_t bytes) { sizeAndFlags = static_cast<uint32_t>(bytes) | (sizeAndFlags & BLOCK_FLAGS); }
+    bool IsAllocated() const { return (sizeAndFlags & BLOCK_IN_USE) != 0; }
+    size_t RequestedSize() const { return Size(); }
+    void SetRequestedSize(size_t) {}
+
+    void SetAllocated(bool state)
+    {
+        sizeAndFlags = state ? sizeAndFlags | BLOCK_IN_USE : sizeAndFlags & ~BLOCK_IN_USE;
+    }
+
+    // Fresh header state: the caller stamps the boundary tags around it
+    void Reset(size_t bytes, bool state)
+    {
+        sizeAndFlags = static_cast<uint32_t>(bytes) | (state ? BLOCK_IN_USE : 0);
+    }
+
+    // Mark the block in use, and tell its successor it has no footer to read
+    void MarkAllocated()
+    {
+        sizeAndFlags |= BLOCK_IN_USE;
+        GetPhysicalNext()->sizeAndFlags &= ~BLOCK_PREV_FREE;
+    }
+
+    // Get pointer to the next block based on address arithmetic
+    MemoryBlock *GetPhysicalNext()
+    {
+        if (Size() == 0)
+            return nullptr; // End of memory
+        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(GetData()) + Size());
+    }
+
+    // Get pointer to the previous block through its footer
+    // Only a free predecessor can be found (and is the only one needed)
+    MemoryBlock *GetPhysicalPrev()
+    {
+        if (!(sizeAndFlags & BLOCK_PREV_FREE))
+            return nullptr;
+        uint32_t prevSize = reinterpret_cast<uint32_t *>(this)[-1];
+        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(this) - prevSize - sizeof(MemoryBlock));
+    }
+
+    // Opaque boundary tag, saved and restored when a block is moved
+    size_t PrevTag() const { return sizeAndFlags & BLOCK_PREV_FREE; }
+    void SetPrevTag(size_t tag) { sizeAndFlags = (sizeAndFlags & ~BLOCK_PREV_FREE) | static_cast<uint32_t>(tag); }
+
+    // Publish this block's state (and, while free, its footer) to the next block
+    void StampBoundaryTag()
+    {
+        MemoryBlock *next = GetPhysicalNext();
+        if (IsAllocated())
+        {
+            next->sizeAndFlags &= ~BLOCK_PREV_FREE;
+            return;
+        }
+        reinterpret_cast<uint32_t *>(next)[-1] = static_cast<uint32_t>(Size());
+        next->sizeAndFlags |= BLOCK_PREV_FREE;
+    }
+
+    // Whether the next block's flag (and this block's footer) agree with this block
+    bool BoundaryTagMatches()
+    {
+        MemoryBlock *next = GetPhysicalNext();
+        if (!(next->sizeAndFlags & BLOCK_PREV_FREE))
+            return IsAllocated();
+        return !IsAllocated() && reinterpret_cast<uint32_t *>(next)[-1] == Size();
+    }
+
+    MemoryBlock *GetLink(BlockLink link, char *linkBase) const
+    {
+        uint32_t offset = static_cast<const uint32_t *>(GetData())[link];
+        return offset ? reinterpret_cast<MemoryBlock *>(linkBase + offset) : nullptr;
+    }
+
+    void SetLink(BlockLink link, MemoryBlock *target, char *linkBase)
+    {
+        static_cast<uint32_t *>(GetData())[link] =
+            target ? static_cast<uint32_t>(reinterpret_cast<char *>(target) - linkBase) : 0;
+    }
+
+    // Offsets hold wherever the heap is mapped
+    void ShiftLinks(uintptr_t) {}
+
+    // The zero-sized marker placed after the last real block
+    bool IsEndMarker() const
+    {
+        return Size() == 0;
+    }
+};
+
+static_assert(sizeof(MemoryBlock) == 8, "compact header must stay 8 bytes");
+
+#endif
+
+// Compact heaps are carved from one reservation, so that 32-bit offsets
+// reach every block
+constexpr size_t COMPACT_HEAP_LIMIT = size_t(1) << 32;
+
+// A compact free block must hold its links and its footer
+constexpr size_t COMPACT_MIN_FREE_PAYLOAD = LINK_COUNT * sizeof(uint32_t) + sizeof(uint32_t);
+
+// Bytes in front of every block: the whole MemoryBlock structure (padded to
+// ALIGNMENT in the full layout, so that every payload and the next header
+// start on an aligned address; see ARENA_PAD for the compact layout)
+constexpr size_t HEADER_SIZE = sizeof(MemoryBlock);
+
+// A relocatable allocation: an opaque id that Resolve turns into the
+// block's current address. 0 is never a valid handle.
+typedef uint64_t MemoryHandle;
+constexpr MemoryHandle NULL_HANDLE = 0;
+
+
+// Heap configuration
+/**
+ * HeapConfig Structure
+ *
+ * Controls how much memory the allocator manages and whether it may grow.
+ * Arenas are reserved from the OS with mmap (VirtualAlloc on Windows); the
+ * OS commits their pages on first touch, and an empty arena only writes
+ * two headers, so reserving a multi-GB heap is cheap.
+ *
+ * Members:
+ *   - heapSize: Size of the initial arena in bytes (0 = the allocator's
+ *               HeapSize parameter, MEMORY_SIZE by default)
+ *   - growable: Add a new arena when an allocation does not fit
+ *   - growthSize: Minimum size of each added arena (0 = heapSize)
+ *   - maxHeapSize: Cap on the total size of all arenas (0 = no cap; a cap
+ *                 below the page-rounded heapSize is rejected)
+ *   - hugePages: Advise transparent huge pages to cut TLB misses
+ *   - heapId: Tag stamped into every block header, so a front-end that
+ *             runs several heaps can tell which one owns a pointer
+ *   - backingFile: Map the heap from this file instead (see Persistent
+ *                  Heaps); a file that already holds a heap is reopened
+ *                  as it was left, otherwise a new heap of heapSize bytes
+ *                  is created in it. File-backed heaps never grow.
+ *   - privateMapping: Map the backing file copy-on-write, so changes stay
+ *                     in this process and the file is left untouched
+ *   - blockIndex: Keep the free blocks in a FreeBlockIndex as well, and
+ *                 run First Fit, Best Fit and Next Fit as vectorised
+ *                 scans over it (same choices as the bin walks). The index lives in
+ *                 process memory: a reopened heap file rebuilds it with
+ *                 one walk over the blocks.
+ */
+struct HeapConfig
+{
+    size_t heapSize = 0;           // Size of the initial arena in bytes (0 = default)
+    bool growable = false;         // Add arenas when an allocation does not fit
+    size_t growthSize = 0;         // Minimum size of each added arena (0 = heapSize)
+    size_t maxHeapSize = 0;        // Cap on the total size of all arenas (0 = no cap)
+    bool hugePages = false;        // Advise transparent huge pages for the arenas
+    uint16_t heapId = 0;           // Tag stamped into every block header
+    std::string backingFile;       // Heap file to map (empty = anonymous memory)
+    bool privateMapping = false;   // Keep changes to the heap file in memory
+    bool blockIndex = false;       // Search First/Best/Next Fit through a FreeBlockIndex
+};
+
+// One contiguous region of the heap
+/**
+ * HeapArena Structure
+ *
+ * Blocks never span arenas: each arena starts with a block that has no
+ * predecessor and ends with its own end marker, stored in the HEADER_SIZE
+ * bytes reserved just past `size`. The first header sits ARENA_PAD bytes
+ * into the mapping (0 with full headers).
+ */
+struct HeapArena
+{
+    char *base;        // Start of the arena (the first block header)
+    size_t size;       // Bytes available for blocks
+    size_t mappedSize; // Bytes reserved from the OS (pad + size + end marker, page-rounded)
+};
+
+// Reserve address space for an arena; pages are committed lazily on first touch
+inline char *ReserveHeapMemory(size_t bytes, bool hugePages)
+{
+#ifdef _WIN32
+    (void)hugePages;
+    return static_cast<char *>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+    {
+        madvise(base, bytes, MADV_HUGEPAGE);
+    }
+#else
+    (void)hugePages;
+#endif
+    return static_cast<char *>(base);
+#endif
+}
+
+// Map a whole heap file, shared or copy-on-write
+inline char *MapHeapFile(int fd, size_t bytes, bool privateMapping, void *hint = nullptr)
+{
+#ifdef _WIN32
+    (void)fd;
+    (void)bytes;
+    (void)privateMapping;
+    (void)hint;
+    return nullptr;
+#else
+    void *base = mmap(hint, bytes, PROT_READ | PROT_WRITE, privateMapping ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    return base == MAP_FAILED ? nullptr : static_cast<char *>(base);
+#endif
+}
+
+// Return an arena's address space to the OS
+inline void ReleaseHeapMemory(char *base, size_t bytes)
+{
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, bytes);
+#endif
+}
+
+// Statistics snapshot
+/**
+ * MemoryStats Structure
+ *
+ * A copy of the allocator's counters at one point in time. The counters
+ * are maintained as blocks are split and merged, so taking a snapshot is
+ * O(1) and never walks the heap.
+ *
+ * Members:
+ *   - totalMemory: Size of the virtual heap in bytes (all arenas)
+ *   - totalAllocated/totalFree: Bytes currently allocated / free
+ *   - allocatedBlocks/freeBlocks: Number of allocated / free blocks
+ *   - largestFreeBlock: Size of largest contiguous free block
+ *   - fragmentation: 1 - largestFreeBlock / totalFree (0.0 = no fragmentation)
+ *   - internalFragmentation: Bytes handed out beyond what callers requested
+ *                            (size rounding, unsplit remainders, buddy orders;
+ *                            always 0 with compact headers, which do not
+ *                            keep the requested size)
+ *   - headerBytes: Bytes taken by block headers (HEADER_SIZE per block)
+ *   - usableBytes: Bytes left for payloads (totalMemory - headerBytes)
+ *   - searches/blocksVisited: Free-block searches run so far / free blocks
+ *                             (or treap nodes) they examined in total
+ *   - reallocsInPlace/reallocsMoved: Reallocate calls resized in place /
+ *                                    satisfied by move-and-copy
+ *   - liveHandles: Allocations currently owned by a handle
+ *   - blocksRelocated/bytesRelocated: Blocks (and their payload bytes)
+ *                                     moved by Compact so far
+ */
+struct MemoryStats
+{
+    size_t totalMemory;      // Size of the virtual heap in bytes
+    size_t totalAllocated;   // Total bytes currently allocated
+    size_t totalFree;        // Total bytes currently free
+    size_t allocatedBlocks;  // Number of allocated blocks
+    size_t freeBlocks;       // Number of free blocks
+    size_t largestFreeBlock; // Size of largest contiguous free block
+    double fragmentation;    // Fragmentation ratio (0.0 = no fragmentation)
+    size_t internalFragmentation; // Allocated bytes beyond the requested sizes
+    size_t headerBytes;      // Bytes taken by block headers
+    size_t usableBytes;      // Bytes left for payloads
+    size_t searches;         // Free-block searches run so far
+    size_t blocksVisited;    // Free blocks examined by those searches
+    size_t reallocsInPlace;  // Reallocations done without moving the block
+    size_t reallocsMoved;    // Reallocations that had to move and copy
+    size_t liveHandles;      // Allocations owned by a handle
+    size_t blocksRelocated;  // Blocks moved by compaction
+    size_t bytesRelocated;   // Payload bytes moved by compaction
+};
+
+// Free-block size distribution
+/**
+ * FreeBlockHistogram Structure
+ *
+ * Free blocks per power-of-two size class - class k covers payload sizes
+ * [2^k, 2^(k+1)), the same classes as the free-list bins. Kept up to date
+ * as blocks enter and leave the bins, so reading it is O(1).
+ *
+ * Members:
+ *   - blocks: Number of free blocks in each class
+ *   - bytes: Total payload bytes of those blocks
+ */
+struct FreeBlockHistogram
+{
+    size_t blocks[NUM_SIZE_CLASSES] = {}; // Free blocks per class
+    size_t bytes[NUM_SIZE_CLASSES] = {};  // Free bytes per class
+};
+
+// Sizes compared per instruction by the FreeBlockIndex scans
+#if defined(__AVX2__)
+constexpr size_t FREE_INDEX_LANES = 8;
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t FREE_INDEX_LANES = 4;
+#else
+constexpr size_t FREE_INDEX_LANES = 1;
+#endif
+
+// Out-of-band index of the free blocks
+/**
+ * FreeBlockIndex Class
+ *
+ * The free blocks as two dense arrays in address order - their offsets
+ * from the heap's link base and their sizes - so First Fit, Best Fit and
+ * Next Fit become linear scans over contiguous sizes instead of walks
+ * through the block headers, and the scans are vectorised (SSE2 or AVX2).
+ *
+ * A removed block leaves a vacant slot behind (size 0, which no request
+ * fits) rather than closing the gap. The next insertion nearby reuses it,
+ * shifting at most a few slots: taking a block and filing the remainder
+ * of its split, or freeing a block and filing the merged one, then moves
+ * nothing. Vacant slots keep offsets in order, so the slots stay sorted
+ * for binary search, and they are squeezed out once they outnumber the
+ * blocks. Updates come in clusters, so a slot is looked up outwards from
+ * the previous update (O(log distance)). Sizes from SATURATED up are
+ * stored as SATURATED.
+ */
+class FreeBlockIndex
+{
+public:
+    static constexpr uint32_t SATURATED = UINT32_MAX; // Stored size of every block this large
+    static constexpr size_t NO_SLOT = SIZE_MAX;       // Search result when nothing fits
+
+private:
+    static constexpr size_t REUSE_DISTANCE = 16; // Vacant slots this close are reused on insertion
+
+    std::vector<uint64_t> offsets; // Block offset of every slot, strictly increasing
+    std::vector<uint32_t> sizes;   // Block size of every slot (0 = vacant)
+    size_t vacant = 0;             // Number of vacant slots
+    size_t finger = 0;             // Slot of the previous update
+
+public:
+    // Forget every block
+    void Clear()
+    {
+        offsets.clear();
+        sizes.clear();
+        vacant = 0;
+        finger = 0;
+    }
+
+    // Index a free block (its offset must not be indexed already)
+    void Insert(uint64_t offset, size_t size)
+    {
+        uint32_t stored = size < SATURATED ? static_cast<uint32_t>(size) : SATURATED;
+        size_t slot = Locate(offset);
+        size_t count = offsets.size();
+
+        // The block's own old slot
+        if (slot < count && offsets[slot] == offset)
+        {
+            sizes[slot] = stored;
+            vacant--;
+            return;
+        }
+
+        // A vacant slot nearby: shift the slots in between over it
+        for (size_t distance = 1; distance <= REUSE_DISTANCE; distance++)
+        {
+            if (slot >= distance && sizes[slot - distance] == 0)
+            {
+                size_t target = slot - distance;
+                std::copy(offsets.begin() + target + 1, offsets.begin() + slot, offsets.begin() + target);
+                std::copy(sizes.begin() + target + 1, sizes.begin() + slot, sizes.begin() + target);
+                Place(slot - 1, offset, stored);
+                return;
+            }
+            if (slot + distance <= count && sizes[slot + distance - 1] == 0)
+            {
+                size_t target = slot + distance - 1;
+                std::copy_backward(offsets.begin() + slot, offsets.begin() + target, offsets.begin() + target + 1);
+                std::copy_backward(sizes.begin() + slot, sizes.begin() + target, sizes.begin() + target + 1);
+                Place(slot, offset, stored);
+                return;
+            }
+        }
+
+        offsets.insert(offsets.begin() + slot, offset);
+        sizes.insert(sizes.begin() + slot, stored);
+        finger = slot;
+    }
+
+    // Drop an indexed block, leaving its slot vacant
+    void Remove(uint64_t offset)
+    {
+        size_t slot = Locate(offset);
+        sizes[slot] = 0;
+        vacant++;
+        finger = slot;
+
+        if (vacant > REUSE_DISTANCE && vacant * 2 > offsets.size())
+        {
+            Squeeze();
+        }
+    }
+
+    /**
+     * First Fit scan
+     *
+     * @param size - Request size (1 .. SATURATED - 1)
+     * @param scanned - Incremented by the number of slots examined
+     * @param from/to - Slots to scan (from <= to; default: all of them)
+     * @return - Slot of the lowest-addressed block of at least size bytes
+     *           in the range, or NO_SLOT
+     */
+    size_t FindFirst(size_t size, size_t &scanned, size_t from = 0, size_t to = SIZE_MAX) const
+    {
+        const uint32_t *data = sizes.data();
+        size_t count = std::min(sizes.size(), to);
+        uint32_t low = static_cast<uint32_t>(size);
+
+        size_t i = from;
+        for (; i + LANES <= count; i += LANES)
+        {
+            unsigned mask = FitMask(data + i, low, SATURATED);
+            if (mask)
+            {
+                size_t slot = i + FloorLog2(mask & (~mask + 1));
+                scanned += slot + 1 - from;
+                return slot;
+            }
+        }
+        for (; i < count; i++)
+        {
+            if (data[i] >= low)
+            {
+                scanned += i + 1 - from;
+                return i;
+            }
+        }
+        scanned += count - from;
+        return NO_SLOT;
+    }
+
+    /**
+     * Best Fit scan
+     *
+     * @param size - Request size (1 .. SATURATED - 1)
+     * @param scanned - Incremented by the number of slots examined
+     * @return - Slot of the smallest block of at least size bytes (the
+     *           lowest-addressed one among equal sizes), or NO_SLOT. Only
+     *           blocks smaller than the best so far pass the vector
+     *           compare, and an exact fit ends the scan.
+     */
+    size_t FindBest(size_t size, size_t &scanned) const
+    {
+        const uint32_t *data = sizes.data();
+        size_t count = sizes.size();
+        uint32_t low = static_cast<uint32_t>(size);
+        uint32_t high = SATURATED; // Sizes that would improve on the best so far
+        size_t best = NO_SLOT;
+
+        size_t i = 0;
+        for (; i < count; i += LANES)
+        {
+            unsigned mask = i + LANES <= count ? FitMask(data + i, low, high) : TailMask(data + i, count - i, low, high);
+            for (; mask; mask &= mask - 1)
+            {
+                size_t slot = i + FloorLog2(mask & (~mask + 1));
+                if (data[slot] > high)
+                    continue;
+
+                best = slot;
+                if (data[slot] == low)
+                {
+                    scanned += slot + 1;
+                    return best;
+                }
+                high = data[slot] - 1;
+            }
+        }
+        scanned += count;
+        return best;
+    }
+
+    // First slot whose block is not below offset (Next Fit resumes there)
+    size_t SlotFrom(uint64_t offset) const { return Locate(offset); }
+
+    // Offset and stored size of a slot
+    uint64_t OffsetAt(size_t slot) const { return offsets[slot]; }
+    uint32_t SizeAt(size_t slot) const { return sizes[slot]; }
+
+    // Indexed blocks
+    size_t Blocks() const { return offsets.size() - vacant; }
+
+private:
+    static constexpr size_t LANES = FREE_INDEX_LANES;
+
+    void Place(size_t slot, uint64_t offset, uint32_t size)
+    {
+        offsets[slot] = offset;
+        sizes[slot] = size;
+        vacant--;
+        finger = slot;
+    }
+
+    // First slot whose offset is not below offset, galloping out from the
+    // finger to bracket it before the binary search
+    size_t Locate(uint64_t offset) const
+    {
+        size_t count = offsets.size();
+        size_t low = 0;
+        size_t high = count;
+        if (finger < count)
+        {
+            size_t step = 1;
+            if (offsets[finger] < offset)
+            {
+                low = finger + 1;
+                while (low + step <= count && offsets[low + step - 1] < offset)
+                {
+                    low += step;
+                    step *= 2;
+                }
+                high = std::min(count, low + step - 1);
+            }
+            else
+            {
+                high = finger;
+                while (high >= step && offsets[high - step] >= offset)
+                {
+                    high -= step;
+                    step *= 2;
+                }
+                low = high >= step ? high - step + 1 : 0;
+            }
+        }
+        return static_cast<size_t>(std::lower_bound(offsets.begin() + low, offsets.begin() + high, offset) - offsets.begin());
+    }
+
+    // Close every vacant slot in one pass
+    void Squeeze()
+    {
+        size_t kept = 0;
+        for (size_t slot = 0; slot < offsets.size(); slot++)
+        {
+            if (sizes[slot])
+            {
+                offsets[kept] = offsets[slot];
+                sizes[kept] = sizes[slot];
+                kept++;
+            }
+        }
+        offsets.resize(kept);
+        sizes.resize(kept);
+        vacant = 0;
+        finger = 0;
+    }
+
+    // Bit l set when low <= chunk[l] <= high, for LANES sizes. Unsigned
+    // compares are done as signed ones on sizes with the top bit flipped.
+    static unsigned FitMask(const uint32_t *chunk, uint32_t low, uint32_t high)
+    {
+#if defined(__AVX2__)
+        const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+        __m256i values = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(chunk)), bias);
+        __m256i aboveLow = _mm256_cmpgt_epi32(values, _mm256_set1_epi32(static_cast<int32_t>((low - 1) ^ 0x80000000u)));
+        __m256i aboveHigh = _mm256_cmpgt_epi32(values, _mm256_set1_epi32(static_cast<int32_t>(high ^ 0x80000000u)));
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(aboveHigh, aboveLow))));
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i bias = _mm_set1_epi32(INT32_MIN);
+        __m128i values = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(chunk)), bias);
+        __m128i aboveLow = _mm_cmpgt_epi32(values, _mm_set1_epi32(static_cast<int32_t>((low - 1) ^ 0x80000000u)));
+        __m128i aboveHigh = _mm_cmpgt_epi32(values, _mm_set1_epi32(static_cast<int32_t>(high ^ 0x80000000u)));
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(aboveHigh, aboveLow))));
+#else
+        return TailMask(chunk, LANES, low, high);
+#endif
+    }
+
+    // FitMask for the last, partial chunk
+    static unsigned TailMask(const uint32_t *chunk, size_t lanes, uint32_t low, uint32_t high)
+    {
+        unsigned mask = 0;
+        for (size_t lane = 0; lane < lanes; lane++)
+        {
+            mask |= static_cast<unsigned>(chunk[lane] >= low && chunk[lane] <= high) << lane;
+        }
+        return mask;
+    }
+};
+
+constexpr char HEAP_FILE_MAGIC[8] = {'H', 'E', 'A', 'P', 'F', 'I', 'L', 'E'};
+constexpr uint32_t HEAP_FILE_VERSION = 2;
+constexpr size_t HEAP_FILE_STATE_BYTES = HEAP_PAGE_SIZE; // The state page in front of the arena
+
+// Persistent heap state
+/**
+ * HeapFileState Structure
+ *
+ * The first page of a heap file; the arena follows it. Blocks find each
+ * other by size and by free-block links, which are plain addresses in the
+ * full header layout (offsets in the compact one). The file is mapped
+ * back at the address it was saved at when that range is free, and then
+ * needs no fixing up; this page holds the rest of the engine's state,
+ * with every pointer stored as an offset from the start of the file
+ * (0 = none), so reopening a heap is a fixed amount of work however many
+ * blocks it holds.
+ *
+ * Members:
+ *   - magic/version: HEAP_FILE_MAGIC and HEAP_FILE_VERSION
+ *   - headerSize/alignment/minBlock: Block layout of the heap, which must
+ *                                    match the engine that opens it
+ *   - strategy: AllocationStrategy the arena is laid out for
+ *   - clean: 1 once the state was saved; 0 while a process has the file
+ *            open for writing (a heap left at 0 was not closed and its
+ *            state page is stale)
+ *   - arenaSize: Bytes available for blocks
+ *   - mappedAt: Address the file was mapped at when the state was saved
+ *   - totalAllocated .. bytesRelocated: The engine's counters
+ *   - binMap/freeBins/freeTreeRoot: The free-block index roots
+ *   - nextFitRover/compactCursor: Where Next Fit and Compact resume
+ *   - freeHistogram: Free blocks per size class
+ */
+struct HeapFileState
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t alignment;
+    uint64_t minBlock;
+    uint32_t strategy;
+    uint32_t clean;
+    uint64_t arenaSize;
+    uint64_t mappedAt;
+    uint64_t totalAllocated;
+    uint64_t totalFree;
+    uint64_t allocatedBlocks;
+    uint64_t freeBlocks;
+    uint64_t largestFreeBlock;
+    uint64_t internalFragmentation;
+    uint64_t searches;
+    uint64_t blocksVisited;
+    uint64_t reallocsInPlace;
+    uint64_t reallocsMoved;
+    uint64_t blocksRelocated;
+    uint64_t bytesRelocated;
+    uint64_t binMap;
+    uint64_t freeBins[NUM_SIZE_CLASSES];
+    uint64_t freeTreeRoot;
+    uint64_t nextFitRover;
+    uint64_t compactCursor;
+    FreeBlockHistogram freeHistogram;
+};
+
+static_assert(sizeof(HeapFileState) <= HEAP_FILE_STATE_BYTES, "The heap state must fit in its page");
+
+// Log-linear histogram
+/**
+ * LogHistogram Structure
+ *
+ * Buckets in the style of HdrHistogram: values below 2^SUB_BITS are
+ * counted exactly, and every power of two above that is split into
+ * 2^SUB_BITS linear sub-buckets. Any value is therefore known to within
+ * about 3%, from 1 to 2^64, in under two thousand counters, and recording
+ * is a couple of shifts and an increment.
+ *
+ * Members:
+ *   - counts: Values recorded per bucket
+ *   - total/sum/maxValue: Number, sum and largest of the recorded values
+ */
+struct LogHistogram
+{
+    static constexpr size_t SUB_BITS = 5;
+    static constexpr size_t SUB_COUNT = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maxValue = 0;
+
+    // Count one value
+    void Record(uint64_t value)
+    {
+        counts[BucketOf(value)]++;
+        total++;
+        sum += value;
+        maxValue = std::max(maxValue, value);
+    }
+
+    // Smallest recorded value v such that a fraction q of all values is <= v
+    // (reported as the top of its bucket, capped at the maximum)
+    uint64_t Percentile(double q) const
+    {
+        if (total == 0)
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, total));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return std::min(BucketTop(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    // Mean of the recorded values
+    double Mean() const
+    {
+        return total > 0 ? static_cast<double>(sum) / total : 0.0;
+    }
+
+    static size_t BucketOf(uint64_t value)
+    {
+        if (value < SUB_COUNT)
+            return static_cast<size_t>(value);
+
+        size_t shift = FloorLog2(value) - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + static_cast<size_t>((value >> shift) - SUB_COUNT);
+    }
+
+    static uint64_t BucketTop(size_t bucket)
+    {
+        if (bucket < SUB_COUNT)
+            return bucket;
+
+        size_t shift = bucket / SUB_COUNT - 1;
+        uint64_t sub = bucket % SUB_COUNT;
+        return ((SUB_COUNT + sub + 1) << shift) - 1;
+    }
+};
+
+// Instrumentation counters
+/**
+ * AllocatorCounters Structure
+ *
+ * Hot-path measurements, kept only when INSTRUMENTATION_ENABLED (all zero
+ * otherwise). The allocator hands out a reference, so polling is free.
+ *
+ * Members:
+ *   - allocateLatency/deallocateLatency: Wall time of each Allocate /
+ *                                        Deallocate call in nanoseconds
+ *   - searchLength: Free blocks (or treap nodes) visited by each search
+ *   - splits: Blocks split in two (including buddy halvings)
+ *   - forwardCoalesces/backwardCoalesces: Merges with the following /
+ *                                         preceding free block (or buddy)
+ *   - failedAllocations: Allocation requests that returned nullptr
+ */
+struct AllocatorCounters
+{
+    LogHistogram allocateLatency;   // Allocate wall time (ns)
+    LogHistogram deallocateLatency; // Deallocate wall time (ns)
+    LogHistogram searchLength;      // Blocks visited per search
+    uint64_t splits = 0;            // Blocks split in two
+    uint64_t forwardCoalesces = 0;  // Merges with the next block
+    uint64_t backwardCoalesces = 0; // Merges with the previous block
+    uint64_t failedAllocations = 0; // Requests that returned nullptr
+};
+
+// Times a scope into a histogram; empty unless instrumentation is enabled
+template <bool Enabled>
+struct ScopedLatency
+{
+    explicit ScopedLatency(LogHistogram &) {}
+};
+
+template <>
+struct ScopedLatency<true>
+{
+    LogHistogram &histogram;
+    std::chrono::steady_clock::time_point start;
+
+    explicit ScopedLatency(LogHistogram &target)
+        : histogram(target), start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedLatency()
+    {
+        histogram.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+};
+
+// Fit policies
+/**
+ * Fit Policies
+ *
+ * A fit policy chooses the free block for each request. The allocator
+ * calls FitPolicy::Find on every allocation, so a fixed policy compiles
+ * down to a direct (and inlinable) call of one search, and the buddy
+ * checks on the allocate/free paths fold away for the fit strategies.
+ *
+ * Each policy provides:
+ *   - RUNTIME: True if the strategy is chosen at run time (SetStrategy)
+ *   - STRATEGY: The strategy (the initial one for RuntimeFitPolicy)
+ *   - Find(heap, size): Pick a free block for an aligned request
+ */
+struct FirstFitPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::FIRST_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.FindFirstFit(size);
+    }
+};
+
+struct NextFitPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::NEXT_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.FindNextFit(size);
+    }
+};
+
+struct BestFitPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::BEST_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.FindBestFit(size);
+    }
+};
+
+struct WorstFitPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::WORST_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.FindWorstFit(size);
+    }
+};
+
+struct TreeBestFitPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::TREE_BEST_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.FindTreeBestFit(size);
+    }
+};
+
+struct BuddyPolicy
+{
+    static constexpr bool RUNTIME = false;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::BUDDY;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        return heap.AllocateBuddyBlock(size);
+    }
+};
+
+// Dispatches on the allocator's current strategy (used by MemoryAllocator)
+struct RuntimeFitPolicy
+{
+    static constexpr bool RUNTIME = true;
+    static constexpr AllocationStrategy STRATEGY = AllocationStrategy::FIRST_FIT;
+
+    template <typename Heap>
+    static MemoryBlock *Find(Heap &heap, size_t size)
+    {
+        switch (heap.strategy)
+        {
+        case AllocationStrategy::FIRST_FIT:
+            return heap.FindFirstFit(size);
+        case AllocationStrategy::BEST_FIT:
+            return heap.FindBestFit(size);
+        case AllocationStrategy::TREE_BEST_FIT:
+            return heap.FindTreeBestFit(size);
+        case AllocationStrategy::BUDDY:
+            return heap.AllocateBuddyBlock(size);
+        case AllocationStrategy::NEXT_FIT:
+            return heap.FindNextFit(size);
+        case AllocationStrategy::WORST_FIT:
+            return heap.FindWorstFit(size);
+        }
+        return nullptr;
+    }
+};
+
+// Memory Allocator engine
+/**
+ * BasicMemoryAllocator Class Template
+ *
+ * This is the core class that simulates OS-level memory management.
+ * It maintains a virtual heap, manages memory blocks, and provides
+ * statistics about memory usage and fragmentation.
+ *
+ * Template Parameters:
+ *   - FitPolicy: How a free block is chosen (see Fit Policies)
+ *   - HeapSize: Initial heap size when HeapConfig::heapSize is 0
+ *   - MinBlock: Smallest payload handed out or split off
+ *   - Alignment: Alignment of every payload (a power of two from
+ *                ALIGNMENT up to HEADER_SIZE, or any larger one with
+ *                compact headers)
+ *
+ * Key Features:
+ *   - Six allocation strategies, fixed at compile time or switched at run time
+ *   - Segregated free lists (one bin per power-of-two size class)
+ *   - Treap index of free blocks for O(log n) Tree Best Fit
+ *   - Optional out-of-band free-block arrays for SIMD First/Best/Next Fit scans
+ *   - Binary buddy allocation over the same heap
+ *   - mmap-backed arenas of configurable size, optionally growing on demand
+ *   - File-backed heaps that reopen in O(1) and fork from checkpoints
+ *   - Automatic block splitting and coalescing
+ *   - Relocatable handle allocations with budgeted, incremental compaction
+ *   - Incremental memory fragmentation tracking
+ *   - Detailed statistics and visualization
+ *   - Safe deallocation with O(1) validation (optional full-heap check)
+ */
+template <typename FitPolicy, size_t HeapSize = MEMORY_SIZE, size_t MinBlock = MIN_BLOCK_SIZE,
+          size_t Alignment = ALIGNMENT>
+class BasicMemoryAllocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+    static_assert(Alignment >= ALIGNMENT && (COMPACT_HEADERS || HEADER_SIZE % Alignment == 0),
+                  "Alignment must be at least ALIGNMENT and divide the header size");
+    static_assert(MinBlock > 0, "MinBlock must be positive");
+
+    // Arenas start this far into their mapping, so that every payload is
+    // aligned even when the header is smaller than Alignment
+    static constexpr size_t ARENA_PAD = (Alignment - HEADER_SIZE % Alignment) % Alignment;
+
+    // Largest arena or request size that can be rounded to whole pages and
+    // then padded and rounded again into a mapping (or aligned into a
+    // block size) without overflowing a size_t
+    static constexpr size_t MAX_ARENA_SIZE = SIZE_MAX - ARENA_PAD - HEADER_SIZE - Alignment - 2 * HEAP_PAGE_SIZE;
+
+    // Buddy blocks span 2^order bytes including their header; the smallest
+    // order must hold a header plus a minimum payload
+    static constexpr size_t BUDDY_MIN_ORDER = CeilLog2(HEADER_SIZE + MinBlock);
+    static_assert((size_t(1) << (BUDDY_MIN_ORDER - 1)) >= HEADER_SIZE, "Each buddy order must map to its own size-class bin");
+    static_assert(HEAP_PAGE_SIZE % (size_t(1) << BUDDY_MIN_ORDER) == 0, "Arenas must split into whole buddy blocks");
+    static_assert(!COMPACT_HEADERS ||
+                      ((MinBlock + HEADER_SIZE + Alignment - 1) & ~(Alignment - 1)) - HEADER_SIZE >= COMPACT_MIN_FREE_PAYLOAD,
+                  "A compact free block must hold its links and footer");
+
+    // Policies call the search functions below
+    friend FitPolicy;
+
+private:
+    HeapConfig config;              // Heap size and growth settings
+    std::vector<HeapArena> arenas;  // The virtual heap, sorted by address
+    size_t heapSize;                // Total bytes across all arenas
+    AllocationStrategy strategy;    // Current allocation strategy
+    bool fullValidation;         // Debug mode: confirm frees by walking the whole heap
+    bool verbose;                // Print failed requests to std::cout
+
+    // Segregated free lists - bin k holds free blocks with size in [2^k, 2^(k+1))
+    // In Buddy mode a block of order k (payload 2^k - HEADER_SIZE) lands in bin
+    // k - 1, so the same bins double as the per-order free lists
+    MemoryBlock *freeBins[NUM_SIZE_CLASSES]; // Head of each size-class free list
+    uint64_t binMap;                         // Bit k set when freeBins[k] is non-empty
+
+    // Every free block is also indexed by (size, address) in a treap
+    MemoryBlock *freeTreeRoot; // Root of the free-block treap
+
+    // ...and, with HeapConfig::blockIndex, by address in dense arrays
+    FreeBlockIndex freeIndex; // Offsets and sizes of the free blocks
+
+    // Statistics members - track memory usage patterns
+    size_t totalAllocated;   // Total bytes currently allocated
+    size_t totalFree;        // Total bytes currently free
+    size_t allocatedBlocks;  // Number of allocated blocks
+    size_t freeBlocks;       // Number of free blocks
+    size_t largestFreeBlock; // Size of largest contiguous free block (the treap maximum)
+    size_t internalFragmentation; // Allocated bytes beyond the requested sizes
+    size_t searches;             // Free-block searches run so far
+    size_t blocksVisited;        // Free blocks examined by those searches
+    size_t reallocsInPlace;      // Reallocations done without moving the block
+    size_t reallocsMoved;        // Reallocations that had to move and copy
+    size_t blocksRelocated;      // Blocks moved by compaction
+    size_t bytesRelocated;       // Payload bytes moved by compaction
+    char *nextFitRover;          // Next Fit resumes its search at this address
+    AllocatorCounters counters;  // Hot-path instrumentation (see INSTRUMENTATION_ENABLED)
+    FreeBlockHistogram freeHistogram; // Free blocks and bytes per size class
+
+    // Handle table - slot i backs the handles with index i; a slot's
+    // generation changes whenever it is freed, so stale handles miss
+    struct HandleSlot
+    {
+        MemoryBlock *block;  // Current block of the handle (nullptr = slot free)
+        uint32_t generation; // Generation of the handle using the slot
+    };
+    std::vector<HandleSlot> handleSlots;                     // Slots by index
+    std::vector<uint32_t> freeHandleSlots;                   // Unused slot indices
+    std::unordered_map<MemoryBlock *, uint32_t> handleOwner; // Slot of each relocatable block
+    MemoryBlock *compactCursor; // Compact resumes at this block header (nullptr = heap start)
+
+    // Compact headers and file-backed heaps: every arena is carved from one
+    // reservation (the file mapping of a file-backed heap); compact
+    // free-block links are offsets from its start
+    char *reservation;      // Start of the reservation (nullptr = none yet)
+    size_t reservationSize; // Bytes reserved
+    size_t reservationUsed; // Bytes already handed to arenas
+    int backingFd;          // Open heap file (-1 = anonymous memory)
+
+protected:
+    /**
+     * Constructor with an explicit initial strategy (runtime policy only)
+     */
+    BasicMemoryAllocator(AllocationStrategy strat, const HeapConfig &heapConfig)
+        : config(heapConfig), heapSize(0), strategy(strat), fullValidation(false),
+          verbose(true),
+          totalAllocated(0), totalFree(0), allocatedBlocks(0), freeBlocks(0),
+          largestFreeBlock(0), internalFragmentation(0),
+          searches(0), blocksVisited(0), reallocsInPlace(0), reallocsMoved(0),
+          blocksRelocated(0), bytesRelocated(0), nextFitRover(nullptr), compactCursor(nullptr),
+          reservation(nullptr), reservationSize(0), reservationUsed(0), backingFd(-1)
+    {
+        // All bins start out empty
+        std::fill(std::begin(freeBins), std::end(freeBins), nullptr);
+        binMap = 0;
+        freeTreeRoot = nullptr;
+
+        // Normalise the configuration to whole pages
+        if (config.heapSize == 0)
+        {
+            config.heapSize = HeapSize;
+        }
+        if (config.heapSize > MAX_ARENA_SIZE || config.growthSize > MAX_ARENA_SIZE)
+        {
+            throw std::bad_alloc();
+        }
+        config.heapSize = RoundToPage(std::max(config.heapSize, HEAP_PAGE_SIZE));
+        config.growthSize = RoundToPage(config.growthSize ? config.growthSize : config.heapSize);
+        if (config.maxHeapSize == 0)
+        {
+            config.maxHeapSize = SIZE_MAX;
+        }
+        if (config.maxHeapSize < config.heapSize)
+        {
+            // A cap below the initial arena could never be honoured
+            throw std::bad_alloc();
+        }
+
+        if (config.backingFile.empty() ? !AddArena(config.heapSize) : !OpenBackingFile())
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+public:
+    /**
+     * Constructor - Initialize the memory allocator
+     *
+     * @param heapConfig - Heap size and growth settings (default: fixed
+     *                     HeapSize bytes)
+     *
+     * Reserves the initial arena and sets it up as one large free block
+     * followed by an end marker. Initializes all statistics.
+     * Throws std::bad_alloc if the arena cannot be reserved (or the
+     * backing file cannot be opened as a heap).
+     */
+    explicit BasicMemoryAllocator(const HeapConfig &heapConfig = HeapConfig())
+        : BasicMemoryAllocator(FitPolicy::STRATEGY, heapConfig)
+    {
+    }
+
+    /**
+     * Destructor - Return every arena to the OS
+     *
+     * A file-backed heap saves its state first, so it can be reopened.
+     */
+    ~BasicMemoryAllocator()
+    {
+        if (backingFd >= 0)
+        {
+            if (!config.privateMapping)
+            {
+                SaveState(true);
+                FlushHeapFile();
+            }
+            ReleaseHeapMemory(reservation, reservationSize);
+#ifndef _WIN32
+            close(backingFd);
+#endif
+            return;
+        }
+        if (reservation)
+        {
+            ReleaseHeapMemory(reservation, reservationSize);
+            return;
+        }
+        for (const HeapArena &arena : arenas)
+        {
+            ReleaseHeapMemory(arena.base - ARENA_PAD, arena.mappedSize);
+        }
+    }
+
+    BasicMemoryAllocator(const BasicMemoryAllocator &) = delete;
+    BasicMemoryAllocator &operator=(const BasicMemoryAllocator &) = delete;
+
+    /**
+     * Set allocation strategy
+     *
+     * @param strat - New allocation strategy to use
+     * @return - True if the strategy was changed
+     *
+     * The fit strategies share one heap layout and can be swapped at any
+     * time. Buddy blocks follow a different layout, so switching to or
+     * from BUDDY is only possible while nothing is allocated. Only the
+     * runtime-dispatched allocator (MemoryAllocator) can switch.
+     */
+    bool SetStrategy(AllocationStrategy strat)
+    {
+        static_assert(FitPolicy::RUNTIME, "The strategy of a fixed fit policy cannot change");
+
+        bool wasBuddy = strategy == AllocationStrategy::BUDDY;
+        bool isBuddy = strat == AllocationStrategy::BUDDY;
+
+        if (wasBuddy != isBuddy)
+        {
+            if (allocatedBlocks > 0)
+            {
+                if (verbose)
+                    std::cout << "ERROR: Free all blocks before switching to or from Buddy allocation.\n";
+                return false;
+            }
+
+            // Nothing is allocated, so every arena can simply be laid out
+            // again for the new strategy
+            std::fill(std::begin(freeBins), std::end(freeBins), nullptr);
+            binMap = 0;
+            freeTreeRoot = nullptr;
+            freeIndex.Clear();
+            freeHistogram = FreeBlockHistogram();
+            largestFreeBlock = 0;
+            freeBlocks = 0;
+            compactCursor = nullptr;
+
+            strategy = strat;
+            for (const HeapArena &arena : arenas)
+            {
+                LayoutEmptyArena(arena);
+            }
+            return true;
+        }
+
+        strategy = strat;
+        return true;
+    }
+
+    /**
+     * Enable or disable error messages
+     *
+     * @param enabled - When false, failed allocations and invalid frees
+     *                  only report through their return values (for
+     *                  batch tools and benchmarks)
+     */
+    void SetVerbose(bool enabled)
+    {
+        verbose = enabled;
+    }
+
+    /**
+     * Whether error messages are printed (front-ends in front of the heap
+     * follow the same setting)
+     */
+    bool IsVerbose() const
+    {
+        return verbose;
+    }
+
+    /**
+     * Enable or disable full-heap validation of frees (debug mode)
+     *
+     * @param enabled - When true, Deallocate also walks every block to
+     *                  confirm the pointer, on top of the O(1) header checks
+     */
+    void SetDebugValidation(bool enabled)
+    {
+        fullValidation = enabled;
+    }
+
+    /**
+     * Allocate memory block
+     *
+     * @param size - Number of bytes to allocate
+     * @return - Pointer to allocated memory, or nullptr if allocation failed
+     *
+     * Finds a suitable free block using the selected strategy, splits it
+     * if necessary, and returns a pointer to the usable data area.
+     */
+    void *Allocate(size_t size)
+    {
+        ScopedLatency<INSTRUMENTATION_ENABLED> timer(counters.allocateLatency);
+
+        if (size == 0)
+            return nullptr;
+
+        if (RequestTooLarge(size))
+        {
+            if (verbose)
+                std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
+            Count(counters.failedAllocations);
+            return nullptr;
+        }
+
+        size_t requestedSize = size;
+
+        // Round up size to minimum block size if needed
+        if (size < MinBlock)
+        {
+            size = MinBlock;
+        }
+
+        // Keep every block (and therefore every header) aligned
+        size = AlignSize(size);
+
+        // Find a suitable block using the selected strategy,
+        // growing the heap by one arena if nothing fits
+        MemoryBlock *block = FindFreeBlock(size);
+        if (!block && GrowHeap(size))
+        {
+            block = FindFreeBlock(size);
+        }
+
+        if (!block)
+        {
+            if (verbose)
+                std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
+            Count(counters.failedAllocations);
+            return nullptr;
+        }
+
+        // Take the block off its free list, then split the block if needed
+        // (a buddy block already comes off its list split to the right order)
+        if (!IsBuddy())
+        {
+            RemoveFreeBlock(block);
+            SplitBlock(block, size);
+        }
+
+        // Mark block as allocated
+        block->MarkAllocated();
+        block->SetRequestedSize(requestedSize);
+
+        // Update statistics
+        internalFragmentation += block->Size() - block->RequestedSize();
+        totalAllocated += block->Size();
+        totalFree -= block->Size();
+        allocatedBlocks++;
+        freeBlocks--;
+
+        return block->GetData();
+    }
+
+    /**
+     * Allocate a group of blocks
+     *
+     * @param sizes - Number of bytes for each block
+     * @param out - Receives one pointer per size (nullptr for a size of 0)
+     * @return - True if every block was allocated; on failure nothing stays
+     *           allocated and out holds only nullptr
+     *
+     * Searches once for a free block that holds the whole group and carves
+     * the blocks from it back to back, so the group also shares cache
+     * lines and pages. If no single block is large enough (or in Buddy
+     * mode) the blocks are allocated one at a time instead. Statistics
+     * are updated once for the whole group.
+     */
+    bool AllocateBatch(const std::vector<size_t> &sizes, std::vector<void *> &out)
+    {
+        out.assign(sizes.size(), nullptr);
+
+        // Total span of the group, headers between the blocks included
+        // (stops counting once it exceeds any arena, before an oversized
+        // request is rounded or the sum can wrap around)
+        size_t limit = config.growable ? std::min(config.maxHeapSize, MAX_ARENA_SIZE) : heapSize;
+        size_t total = 0;
+        size_t count = 0;
+        for (size_t size : sizes)
+        {
+            if (size == 0)
+                continue;
+            if (total <= limit)
+            {
+                if (RequestTooLarge(size))
+                {
+                    total = limit + 1;
+                }
+                else
+                {
+                    size_t span = (count > 0 ? HEADER_SIZE : 0) + AlignSize(std::max(size, MinBlock));
+                    total = limit - total < span ? limit + 1 : total + span;
+                }
+            }
+            count++;
+        }
+        if (count == 0)
+            return true;
+
+        MemoryBlock *block = nullptr;
+        if (!IsBuddy() && total <= limit)
+        {
+            block = FindFreeBlock(total);
+        }
+
+        if (!block)
+        {
+            return AllocateEach(sizes, out);
+        }
+
+        RemoveFreeBlock(block);
+
+        size_t carved = 0;
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            if (sizes[i] == 0)
+                continue;
+
+            size_t size = AlignSize(std::max(sizes[i], MinBlock));
+            if (++carved < count)
+            {
+                // Cut the block off the front; the rest stays off the free
+                // lists until the last block is placed
+                MemoryBlock *rest = reinterpret_cast<MemoryBlock *>(
+                    reinterpret_cast<char *>(block->GetData()) + size);
+                InitBlock(rest, block->Size() - size - HEADER_SIZE, false);
+                rest->StampBoundaryTag();
+                block->SetSize(size);
+                block->StampBoundaryTag();
+                freeBlocks++;
+                Count(counters.splits);
+            }
+            else
+            {
+                SplitBlock(block, size);
+            }
+
+            block->MarkAllocated();
+            block->SetRequestedSize(sizes[i]);
+            out[i] = block->GetData();
+
+            // Update statistics
+            internalFragmentation += block->Size() - block->RequestedSize();
+            totalAllocated += block->Size();
+            totalFree -= block->Size();
+
+            block = block->GetPhysicalNext();
+        }
+        allocatedBlocks += count;
+        freeBlocks -= count;
+
+        return true;
+    }
+
+    /**
+     * Allocate memory with a stronger alignment than Alignment
+     *
+     * @param size - Number of bytes to allocate
+     * @param alignment - Required alignment of the returned pointer (a power of two)
+     * @return - Aligned pointer to allocated memory, or nullptr if allocation
+     *           failed; release it with Deallocate like any other block
+     *
+     * Searches for a block with room for the worst-case leading padding,
+     * then places a header just before the first suitably aligned address.
+     * The padding in front becomes a free block of its own (so it is at
+     * least one header plus MinBlock long, or empty), and the tail is split
+     * off as usual. Buddy blocks cannot move their header, so in Buddy mode
+     * only their natural alignment is available. Reallocate keeps the
+     * alignment only when it resizes in place.
+     */
+    void *AllocateAligned(size_t size, size_t alignment)
+    {
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        {
+            if (verbose)
+                std::cout << "ERROR: Alignment must be a power of two.\n";
+            return nullptr;
+        }
+
+        if (alignment <= NaturalAlignment())
+            return Allocate(size);
+
+        if (IsBuddy())
+        {
+            if (verbose)
+                std::cout << "ERROR: Buddy blocks cannot be aligned beyond " << NaturalAlignment() << " bytes.\n";
+            return nullptr;
+        }
+
+        if (size == 0)
+            return nullptr;
+
+        // Room for the block plus the largest leading gap that may be needed;
+        // the rounded size plus the slack must still fit in an arena
+        size_t slack = alignment + HEADER_SIZE + MinBlock;
+        if (RequestTooLarge(size) || alignment > MAX_ARENA_SIZE ||
+            std::min(config.maxHeapSize, MAX_ARENA_SIZE) - size < slack + Alignment)
+        {
+            if (verbose)
+                std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
+            Count(counters.failedAllocations);
+            return nullptr;
+        }
+
+        size_t requestedSize = size;
+        size = AlignSize(std::max(size, MinBlock));
+
+        MemoryBlock *block = FindFreeBlock(size + slack);
+        if (!block && GrowHeap(size + slack))
+        {
+            block = FindFreeBlock(size + slack);
+        }
+
+        if (!block)
+        {
+            if (verbose)
+                std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
+            Count(counters.failedAllocations);
+            return nullptr;
+        }
+
+        RemoveFreeBlock(block);
+
+        // First aligned address whose gap is empty or can hold a free block
+        char *data = static_cast<char *>(block->GetData());
+        char *aligned = data + ((alignment - reinterpret_cast<uintptr_t>(data) % alignment) % alignment);
+        while (aligned != data && static_cast<size_t>(aligned - data) < HEADER_SIZE + MinBlock)
+        {
+            aligned += alignment;
+        }
+
+        if (aligned != data)
+        {
+            size_t gap = static_cast<size_t>(aligned - data);
+
+            // Set up the aligned block in the upper part of the free block
+            MemoryBlock *alignedBlock = reinterpret_cast<MemoryBlock *>(aligned - HEADER_SIZE);
+            InitBlock(alignedBlock, block->Size() - gap, true);
+            alignedBlock->StampBoundaryTag();
+
+            // The leading gap goes back as a free block
+            block->SetSize(gap - HEADER_SIZE);
+            block->StampBoundaryTag();
+            freeBlocks++;
+            CoalesceBlocks(block);
+
+            block = alignedBlock;
+        }
+
+        SplitBlock(block, size);
+
+        // Mark block as allocated
+        block->MarkAllocated();
+        block->SetRequestedSize(requestedSize);
+
+        // Update statistics
+        internalFragmentation += block->Size() - block->RequestedSize();
+        totalAllocated += block->Size();
+        totalFree -= block->Size();
+        allocatedBlocks++;
+        freeBlocks--;
+
+        return block->GetData();
+    }
+
+    /**
+     * Deallocate memory block
+     *
+     * @param ptr - Pointer to previously allocated memory
+     * @return - True if deallocation succeeded, false otherwise
+     *
+     * Marks a block as free and attempts to coalesce with adjacent
+     * free blocks to reduce fragmentation.
+     */
+    bool Deallocate(void *ptr)
+    {
+        ScopedLatency<INSTRUMENTATION_ENABLED> timer(counters.deallocateLatency);
+
+        if (!ptr)
+            return false;
+
+        // Calculate the block address from the data pointer
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+
+        // Validate the block
+        if (!IsValidBlock(block) || !block->IsAllocated())
+        {
+            if (verbose)
+                std::cout << "ERROR: Invalid deallocation request.\n";
+            return false;
+        }
+
+        // A relocatable block belongs to its handle
+        if (!handleOwner.empty() && handleOwner.count(block))
+        {
+            if (verbose)
+                std::cout << "ERROR: Block is owned by a handle; release it with FreeHandle.\n";
+            return false;
+        }
+
+        // Mark block as free
+        block->SetAllocated(false);
+
+        // Update statistics
+        internalFragmentation -= block->Size() - block->RequestedSize();
+        totalAllocated -= block->Size();
+        totalFree += block->Size();
+        allocatedBlocks--;
+        freeBlocks++;
+
+        // Attempt to coalesce with adjacent blocks (or merge with buddies)
+        if (IsBuddy())
+        {
+            FreeBuddyBlock(block);
+        }
+        else
+        {
+            CoalesceBlocks(block);
+        }
+
+        return true;
+    }
+
+    /**
+     * Deallocate a group of blocks
+     *
+     * @param ptrs - Pointers to previously allocated memory (nullptr
+     *               entries are ignored)
+     * @return - True if every block was freed; false if any pointer is
+     *           invalid or repeated, in which case nothing is freed
+     *
+     * Validates the whole group first, then frees the blocks in address
+     * order: physically adjacent blocks of the group are merged into one
+     * run directly, and each run coalesces with its free neighbours once.
+     * Statistics are updated once for the whole group.
+     */
+    bool DeallocateBatch(const std::vector<void *> &ptrs)
+    {
+        std::vector<MemoryBlock *> blocks;
+        blocks.reserve(ptrs.size());
+        for (void *ptr : ptrs)
+        {
+            if (ptr)
+            {
+                blocks.push_back(reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(ptr) - HEADER_SIZE));
+            }
+        }
+        std::sort(blocks.begin(), blocks.end());
+
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            MemoryBlock *block = blocks[i];
+            if ((i > 0 && blocks[i - 1] == block) || !IsValidBlock(block) || !block->IsAllocated() ||
+                (!handleOwner.empty() && handleOwner.count(block)))
+            {
+                if (verbose)
+                    std::cout << "ERROR: Invalid deallocation request.\n";
+                return false;
+            }
+        }
+
+        // Update statistics
+        for (MemoryBlock *block : blocks)
+        {
+            internalFragmentation -= block->Size() - block->RequestedSize();
+            totalAllocated -= block->Size();
+            totalFree += block->Size();
+        }
+        allocatedBlocks -= blocks.size();
+        freeBlocks += blocks.size();
+
+        size_t i = 0;
+        while (i < blocks.size())
+        {
+            MemoryBlock *run = blocks[i++];
+            run->SetAllocated(false);
+
+            if (IsBuddy())
+            {
+                FreeBuddyBlock(run);
+                continue;
+            }
+
+            // Absorb the members of the group that directly follow
+            while (i < blocks.size() && blocks[i] == run->GetPhysicalNext())
+            {
+                MemoryBlock *next = blocks[i++];
+                run->SetSize(run->Size() + next->Size() + HEADER_SIZE);
+                next->magic = 0;
+                if (compactCursor == next)
+                {
+                    compactCursor = run;
+                }
+                freeBlocks--;
+                Count(counters.forwardCoalesces);
+            }
+            run->StampBoundaryTag();
+
+            CoalesceBlocks(run);
+        }
+
+        return true;
+    }
+
+    /**
+     * Size a block was requested with
+     *
+     * @param ptr - Pointer to previously allocated memory
+     * @return - The requested size in bytes, or 0 if ptr is not an
+     *           allocated block of this heap
+     */
+    size_t GetRequestedSize(void *ptr) const
+    {
+        if (!ptr)
+            return 0;
+
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+        return IsValidBlock(block) && block->IsAllocated() ? block->RequestedSize() : 0;
+    }
+
+    /**
+     * Size of the block serving an allocation
+     *
+     * @param ptr - Pointer to previously allocated memory
+     * @return - The block size in bytes (header excluded, as ForEachBlock
+     *           reports it), or 0 if ptr is not an allocated block of this heap
+     */
+    size_t GetBlockSize(void *ptr) const
+    {
+        if (!ptr)
+            return 0;
+
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+        return IsValidBlock(block) && block->IsAllocated() ? block->Size() : 0;
+    }
+
+    /**
+     * Resize an allocated block
+     *
+     * @param ptr - Pointer to previously allocated memory (nullptr = Allocate)
+     * @param size - New size in bytes (0 = Deallocate)
+     * @return - Pointer to the resized memory, or nullptr if it failed (the
+     *           old block is then left untouched, like realloc)
+     *
+     * Shrinking splits the tail off as a free block, which coalesces with a
+     * free neighbour. Growing absorbs the physically next block when it is
+     * free and large enough (in Buddy mode: the free buddies above the
+     * block). Only when neither works is the data moved to a new block.
+     */
+    void *Reallocate(void *ptr, size_t size)
+    {
+        if (!ptr)
+            return Allocate(size);
+
+        if (size == 0)
+        {
+            Deallocate(ptr);
+            return nullptr;
+        }
+
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+        if (!IsValidBlock(block) || !block->IsAllocated() ||
+            (!handleOwner.empty() && handleOwner.count(block)))
+        {
+            if (verbose)
+                std::cout << "ERROR: Invalid reallocation request.\n";
+            return nullptr;
+        }
+
+        // Reject before rounding (a size near SIZE_MAX would wrap to 0);
+        // the old block stays valid
+        if (RequestTooLarge(size))
+        {
+            if (verbose)
+                std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
+            Count(counters.failedAllocations);
+            return nullptr;
+        }
+
+        size_t requestedSize = size;
+        size_t oldSize = block->Size();
+        size_t oldSlack = oldSize - block->RequestedSize();
+        size = AlignSize(std::max(size, MinBlock));
+
+        if (IsBuddy() ? ResizeBuddyInPlace(block, size) : ResizeInPlace(block, size))
+        {
+            // Update statistics
+            block->SetRequestedSize(requestedSize);
+            internalFragmentation += block->Size() - block->RequestedSize();
+            internalFragmentation -= oldSlack;
+            totalAllocated += block->Size();
+            totalAllocated -= oldSize;
+            totalFree += oldSize;
+            totalFree -= block->Size();
+            reallocsInPlace++;
+            return ptr;
+        }
+
+        // Move and copy; on failure the old block stays valid
+        void *newPtr = Allocate(requestedSize);
+        if (!newPtr)
+        {
+            return nullptr;
+        }
+        std::memcpy(newPtr, ptr, std::min(block->RequestedSize(), requestedSize));
+        Deallocate(ptr);
+        reallocsMoved++;
+        return newPtr;
+    }
+
+    /**
+     * Allocate a relocatable block
+     *
+     * @param size - Number of bytes to allocate
+     * @return - Handle of the new block, or NULL_HANDLE if allocation failed
+     *
+     * The block is reached through Resolve, so Compact may move it. Raw
+     * pointers from Resolve stay valid only until the next Compact call.
+     */
+    MemoryHandle AllocateHandle(size_t size)
+    {
+        void *ptr = Allocate(size);
+        if (!ptr)
+            return NULL_HANDLE;
+
+        uint32_t index;
+        if (!freeHandleSlots.empty())
+        {
+            index = freeHandleSlots.back();
+            freeHandleSlots.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(handleSlots.size());
+            handleSlots.push_back(HandleSlot{nullptr, 0});
+        }
+
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
+            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
+        handleSlots[index].block = block;
+        handleOwner.emplace(block, index);
+
+        // Index in the low half (offset by one, so no handle is 0),
+        // generation in the high half
+        return (static_cast<MemoryHandle>(handleSlots[index].generation) << 32) | (index + 1ULL);
+    }
+
+    /**
+     * Current address of a relocatable block
+     *
+     * @param handle - Handle returned by AllocateHandle
+     * @return - Pointer to the block's data, or nullptr if the handle is
+     *           not live
+     */
+    void *Resolve(MemoryHandle handle) const
+    {
+        const HandleSlot *slot = FindHandleSlot(handle);
+        return slot ? slot->block->GetData() : nullptr;
+    }
+
+    /**
+     * Free a relocatable block
+     *
+     * @param handle - Handle returned by AllocateHandle
+     * @return - True if the handle was live and its block is now free
+     */
+    bool FreeHandle(MemoryHandle handle)
+    {
+        HandleSlot *slot = FindHandleSlot(handle);
+        if (!slot)
+        {
+            if (verbose)
+                std::cout << "ERROR: Invalid handle.\n";
+            return false;
+        }
+
+        MemoryBlock *block = slot->block;
+        handleOwner.erase(block);
+        slot->block = nullptr;
+        slot->generation++;
+        freeHandleSlots.push_back(static_cast<uint32_t>(slot - handleSlots.data()));
+
+        return Deallocate(block->GetData());
+    }
+
+    /**
+     * Run one step of incremental compaction
+     *
+     * @param maxBytes - Most payload bytes to move in this call
+     * @return - Payload bytes moved
+     *
+     * Walks the heap in address order from where the previous call
+     * stopped. Whenever a free block is followed by a relocatable block,
+     * the block slides down over the free space and the gap moves up,
+     * merging with the free block after it. Repeated calls therefore push
+     * free space towards the end of each arena, where it ends up as one
+     * tail block. Blocks allocated with Allocate are pinned and split the
+     * heap into regions that compact separately; a relocatable block larger
+     * than maxBytes is also left in place. A call stops when the budget
+     * runs out or the walk reaches the end of the heap, and the next call
+     * then starts over. Buddy blocks cannot slide, so in Buddy mode
+     * nothing is moved.
+     */
+    size_t Compact(size_t maxBytes)
+    {
+        if (IsBuddy() || handleOwner.empty())
+            return 0;
+
+        size_t moved = 0;
+        MemoryBlock *current = compactCursor ? compactCursor : reinterpret_cast<MemoryBlock *>(arenas.front().base);
+        size_t arenaIndex = static_cast<size_t>(FindArena(current) - arenas.data());
+
+        while (true)
+        {
+            if (current->IsEndMarker())
+            {
+                if (++arenaIndex == arenas.size())
+                {
+                    // A whole pass is done; the next call starts over
+                    compactCursor = nullptr;
+                    return moved;
+                }
+                current = reinterpret_cast<MemoryBlock *>(arenas[arenaIndex].base);
+                continue;
+            }
+
+            if (!current->IsAllocated())
+            {
+                MemoryBlock *next = current->GetPhysicalNext();
+                auto owner = next->IsEndMarker() ? handleOwner.end() : handleOwner.find(next);
+                if (owner != handleOwner.end() && next->Size() <= maxBytes)
+                {
+                    if (moved + next->Size() > maxBytes)
+                    {
+                        // Out of budget: resume at this free block
+                        compactCursor = current;
+                        return moved;
+                    }
+
+                    moved += next->Size();
+                    current = SlideBlock(current, next, owner->second);
+                    continue;
+                }
+            }
+
+            current = current->GetPhysicalNext();
+        }
+    }
+
+    /**
+     * Get a snapshot of the memory statistics
+     *
+     * @return - Current counters plus the derived fragmentation ratio
+     *
+     * O(1): every figure is kept up to date by SplitBlock and
+     * CoalesceBlocks, so no blocks are visited.
+     */
+    MemoryStats GetStats() const
+    {
+        MemoryStats stats;
+        stats.totalMemory = heapSize;
+        stats.totalAllocated = totalAllocated;
+        stats.totalFree = totalFree;
+        stats.allocatedBlocks = allocatedBlocks;
+        stats.freeBlocks = freeBlocks;
+        stats.largestFreeBlock = largestFreeBlock;
+        stats.internalFragmentation = internalFragmentation;
+        stats.headerBytes = (allocatedBlocks + freeBlocks) * HEADER_SIZE;
+        stats.usableBytes = heapSize - stats.headerBytes;
+        stats.searches = searches;
+        stats.blocksVisited = blocksVisited;
+        stats.reallocsInPlace = reallocsInPlace;
+        stats.reallocsMoved = reallocsMoved;
+        stats.liveHandles = handleOwner.size();
+        stats.blocksRelocated = blocksRelocated;
+        stats.bytesRelocated = bytesRelocated;
+
+        // Calculate fragmentation as (1 - largest_free_block / total_free_memory)
+        if (totalFree > 0)
+        {
+            stats.fragmentation = 1.0 - (static_cast<double>(largestFreeBlock) / totalFree);
+        }
+        else
+        {
+            stats.fragmentation = 0.0;
+        }
+        return stats;
+    }
+
+    /**
+     * Hot-path instrumentation counters
+     *
+     * @return - The live counters (all zero unless the allocator was built
+     *           with ALLOCATOR_INSTRUMENTATION); reading them costs nothing
+     */
+    const AllocatorCounters &GetCounters() const
+    {
+        return counters;
+    }
+
+    /**
+     * Free-block size distribution
+     *
+     * @return - Free blocks and bytes per power-of-two size class (O(1))
+     */
+    const FreeBlockHistogram &GetFreeHistogram() const
+    {
+        return freeHistogram;
+    }
+
+    /**
+     * Free bytes that cannot serve a request
+     *
+     * @param size - Request size in bytes
+     * @return - Free bytes held in blocks too small for the request
+     *
+     * The classes below the request's class count in full from the
+     * histogram; only the bin of the request's own class is walked.
+     */
+    size_t UnusableBytes(size_t size) const
+    {
+        size_t needed = BlockSizeFor(size);
+        size_t bin = SizeClass(needed);
+
+        size_t unusable = 0;
+        for (size_t i = 0; i < bin; i++)
+        {
+            unusable += freeHistogram.bytes[i];
+        }
+        for (MemoryBlock *current = freeBins[bin]; current; current = Link(current, LINK_NEXT_FREE))
+        {
+            if (current->Size() < needed)
+            {
+                unusable += current->Size();
+            }
+        }
+        return unusable;
+    }
+
+    /**
+     * Number of requests of one size the free space could serve
+     *
+     * @param size - Request size in bytes
+     * @return - How many such requests would fit at once without growing
+     *           the heap (each block carved into as many as it holds)
+     *
+     * Walks the bins from the request's class up, so it costs O(free
+     * blocks that are large enough).
+     */
+    size_t AllocatableCount(size_t size) const
+    {
+        size_t needed = BlockSizeFor(size);
+
+        size_t count = 0;
+        for (size_t bin = SizeClass(needed); bin < NUM_SIZE_CLASSES; bin++)
+        {
+            for (MemoryBlock *current = freeBins[bin]; current; current = Link(current, LINK_NEXT_FREE))
+            {
+                if (current->Size() >= needed)
+                {
+                    count += (current->Size() + HEADER_SIZE) / (needed + HEADER_SIZE);
+                }
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Largest free block of a size class
+     *
+     * @param sizeClass - Class k, covering payload sizes [2^k, 2^(k+1))
+     * @return - Size of its largest free block (0 if the class is empty);
+     *           walks the class's bin
+     */
+    size_t LargestFreeInClass(size_t sizeClass) const
+    {
+        size_t largest = 0;
+        if (sizeClass < NUM_SIZE_CLASSES)
+        {
+            for (MemoryBlock *current = freeBins[sizeClass]; current; current = Link(current, LINK_NEXT_FREE))
+            {
+                largest = std::max(largest, current->Size());
+            }
+        }
+        return largest;
+    }
+
+    /**
+     * Print the free-space distribution
+     *
+     * Shows every non-empty size class with its block count, bytes and
+     * largest block, then for a range of request sizes how many bytes are
+     * unusable for them and how many such requests would still fit.
+     */
+    void PrintFreeSpaceReport() const
+    {
+        std::cout << "\n===== FREE SPACE REPORT =====\n";
+        std::cout << std::left << std::setw(24) << "Size Class"
+                  << std::setw(10) << "Blocks"
+                  << std::setw(14) << "Bytes"
+                  << "Largest\n";
+        std::cout << std::string(60, '-') << "\n";
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        {
+            if (freeHistogram.blocks[i] == 0)
+                continue;
+
+            std::string range = "[" + std::to_string(size_t(1) << i) + ", " +
+                                (i + 1 < 64 ? std::to_string(size_t(1) << (i + 1)) : std::string("max")) + ")";
+            std::cout << std::left << std::setw(24) << range
+                      << std::setw(10) << freeHistogram.blocks[i]
+                      << std::setw(14) << freeHistogram.bytes[i]
+                      << LargestFreeInClass(i) << "\n";
+        }
+
+        std::cout << "\n" << std::left << std::setw(16) << "Request Size"
+                  << std::setw(18) << "Unusable Bytes"
+                  << "Requests That Fit\n";
+        std::cout << std::string(60, '-') << "\n";
+        for (size_t size = 64; size <= (size_t(1) << 20); size <<= 2)
+        {
+            std::cout << std::left << std::setw(16) << size
+                      << std::setw(18) << UnusableBytes(size)
+                      << AllocatableCount(size) << "\n";
+        }
+        std::cout << "=============================\n\n";
+    }
+
+    /**
+     * Print comprehensive memory usage report
+     *
+     * Shows:
+     *   - Total and available memory
+     *   - Number of allocated and free blocks
+     *   - Fragmentation percentage
+     *   - Internal fragmentation (bytes lost to rounding)
+     *   - Header overhead per block and bytes left for payloads
+     *   - Current allocation strategy
+     *   - Number of arenas and whether the heap can grow
+     */
+    void PrintMemoryReport() const
+    {
+        MemoryStats stats = GetStats();
+
+        std::cout << "\n===== MEMORY ALLOCATOR REPORT =====\n";
+        std::cout << "Total Memory: " << stats.totalMemory << " bytes\n";
+        std::cout << "Allocation Strategy: " << StrategyName(strategy) << "\n";
+        std::cout << "Heap Arenas: " << arenas.size();
+        if (config.growable)
+        {
+            std::cout << " (growable";
+            if (config.maxHeapSize != SIZE_MAX)
+            {
+                std::cout << " up to " << config.maxHeapSize << " bytes";
+            }
+            std::cout << ")";
+        }
+        std::cout << "\n";
+        std::cout << "Total Allocated: " << stats.totalAllocated << " bytes ("
+                  << std::fixed << std::setprecision(2) << (stats.totalAllocated * 100.0 / stats.totalMemory) << "%)\n";
+        std::cout << "Total Free: " << stats.totalFree << " bytes ("
+                  << std::fixed << std::setprecision(2) << (stats.totalFree * 100.0 / stats.totalMemory) << "%)\n";
+        std::cout << "Allocated Blocks: " << stats.allocatedBlocks << "\n";
+        std::cout << "Free Blocks: " << stats.freeBlocks << "\n";
+        std::cout << "Largest Free Block: " << stats.largestFreeBlock << " bytes\n";
+        std::cout << "Memory Fragmentation: " << std::fixed << std::setprecision(2)
+                  << (stats.fragmentation * 100.0) << "%\n";
+        if (COMPACT_HEADERS)
+        {
+            std::cout << "Internal Fragmentation: not tracked (compact headers)\n";
+        }
+        else
+        {
+            std::cout << "Internal Fragmentation: " << stats.internalFragmentation << " bytes ("
+                      << std::fixed << std::setprecision(2)
+                      << (stats.totalAllocated > 0 ? stats.internalFragmentation * 100.0 / stats.totalAllocated : 0.0)
+                      << "% of allocated)\n";
+        }
+        std::cout << "Block Headers: " << HEADER_SIZE << " bytes per block ("
+                  << (COMPACT_HEADERS ? "compact" : "full") << "), " << stats.headerBytes << " bytes in total\n";
+        std::cout << "Usable Bytes: " << stats.usableBytes << " bytes ("
+                  << std::fixed << std::setprecision(2) << (stats.usableBytes * 100.0 / stats.totalMemory) << "%)\n";
+        std::cout << "Search Cost: " << std::fixed << std::setprecision(2)
+                  << (stats.searches > 0 ? static_cast<double>(stats.blocksVisited) / stats.searches : 0.0)
+                  << " blocks visited per search (" << stats.searches << " searches)\n";
+        if (stats.reallocsInPlace + stats.reallocsMoved > 0)
+        {
+            std::cout << "Reallocations: " << stats.reallocsInPlace << " in place, "
+                      << stats.reallocsMoved << " moved\n";
+        }
+        if (stats.liveHandles + stats.blocksRelocated > 0)
+        {
+            std::cout << "Relocatable Handles: " << stats.liveHandles << " live, "
+                      << stats.blocksRelocated << " blocks (" << stats.bytesRelocated
+                      << " bytes) relocated by compaction\n";
+        }
+        if constexpr (INSTRUMENTATION_ENABLED)
+        {
+            std::cout << "--- Instrumentation ---\n";
+            PrintHistogram("Allocate Latency", counters.allocateLatency, "ns");
+            PrintHistogram("Deallocate Latency", counters.deallocateLatency, "ns");
+            PrintHistogram("Search Length", counters.searchLength, "blocks");
+            std::cout << "Splits: " << counters.splits << "\n";
+            std::cout << "Coalesces: " << counters.forwardCoalesces << " forward, "
+                      << counters.backwardCoalesces << " backward\n";
+            std::cout << "Failed Allocations: " << counters.failedAllocations << "\n";
+        }
+        std::cout << "==================================\n\n";
+    }
+
+    /**
+     * Print visual memory map
+     *
+     * Shows a text-based visualization of memory usage:
+     *   A = Allocated block
+     *   F = Free block
+     */
+    void PrintMemoryMap() const
+    {
+        std::cout << "\n===== MEMORY MAP =====\n";
+        std::cout << "Each symbol represents " << (heapSize / 100) << " bytes\n";
+        std::cout << "[A] = Allocated, [F] = Free\n";
+
+        int symbolCount = 0;
+        int lineCount = 0;
+
+        for (const HeapArena &arena : arenas)
+        {
+            MemoryBlock *current = reinterpret_cast<MemoryBlock *>(arena.base);
+            while (!current->IsEndMarker())
+            {
+                size_t blockSymbols = current->Size() / (heapSize / 100);
+                if (blockSymbols == 0)
+                    blockSymbols = 1;
+
+                for (size_t i = 0; i < blockSymbols; i++)
+                {
+                    std::cout << (current->IsAllocated() ? "A" : "F");
+                    symbolCount++;
+
+                    if (symbolCount % 50 == 0)
+                    {
+                        std::cout << " " << (lineCount * 50 + 1) << "-" << (lineCount + 1) * 50 << "\n";
+                        lineCount++;
+                    }
+                }
+
+                current = current->GetPhysicalNext();
+            }
+        }
+
+        if (symbolCount % 50 != 0)
+        {
+            std::cout << " " << ((lineCount * 50) + 1) << "-" << symbolCount << "\n";
+        }
+        std::cout << "====================\n\n";
+    }
+
+    /**
+     * Print detailed block information
+     *
+     * Displays a table with information about each memory block
+     */
+    void PrintBlockDetails() const
+    {
+        std::cout << "\n===== BLOCK DETAILS =====\n";
+        std::cout << std::left << std::setw(20) << "Block Address"
+                  << std::setw(15) << "Size (bytes)"
+                  << std::setw(12) << "Status"
+                  << "Data Address\n";
+        std::cout << std::string(60, '-') << "\n";
+
+        for (size_t i = 0; i < arenas.size(); i++)
+        {
+            if (arenas.size() > 1)
+            {
+                std::cout << "-- Arena " << (i + 1) << " (" << arenas[i].size << " bytes) --\n";
+            }
+
+            MemoryBlock *current = reinterpret_cast<MemoryBlock *>(arenas[i].base);
+            while (!current->IsEndMarker())
+            {
+                std::cout << std::left << std::setw(20) << current
+                          << std::setw(15) << current->Size()
+                          << std::setw(12) << (current->IsAllocated() ? "Allocated" : "Free")
+                          << current->GetData() << "\n";
+                current = current->GetPhysicalNext();
+            }
+        }
+        std::cout << "=======================\n\n";
+    }
+
+    /**
+     * Current allocation strategy
+     */
+    AllocationStrategy GetStrategy() const
+    {
+        return strategy;
+    }
+
+    /**
+     * Visit every block in address order
+     *
+     * @param visit - Called as visit(offset, size, allocated) for each block,
+     *                where offset is the position of the block header in the
+     *                virtual heap (the arenas numbered back to back in
+     *                address order) and size excludes the header
+     */
+    template <typename Visitor>
+    void ForEachBlock(Visitor visit) const
+    {
+        size_t arenaOffset = 0;
+        for (const HeapArena &arena : arenas)
+        {
+            MemoryBlock *current = reinterpret_cast<MemoryBlock *>(arena.base);
+            while (!current->IsEndMarker())
+            {
+                visit(arenaOffset + static_cast<size_t>(reinterpret_cast<char *>(current) - arena.base),
+                      current->Size(), current->IsAllocated());
+                current = current->GetPhysicalNext();
+            }
+            arenaOffset += arena.size;
+        }
+    }
+
+    /**
+     * Number of arenas the heap is made of (grows with GrowHeap, never shrinks)
+     */
+    size_t GetArenaCount() const
+    {
+        return arenas.size();
+    }
+
+    /**
+     * Visit every arena in address order
+     *
+     * @param visit - Called as visit(begin, end) with the address range that
+     *                holds the arena's block headers (end marker excluded)
+     */
+    template <typename Visitor>
+    void ForEachArena(Visitor visit) const
+    {
+        for (const HeapArena &arena : arenas)
+        {
+            visit(static_cast<const char *>(arena.base), static_cast<const char *>(arena.base + arena.size));
+        }
+    }
+
+    /**
+     * Position of an allocation's block header in the virtual heap
+     *
+     * @param ptr - Pointer to allocated memory
+     * @return - The offset ForEachBlock reports for the block, or SIZE_MAX
+     *           if ptr is not in the heap
+     */
+    size_t BlockOffset(const void *ptr) const
+    {
+        const char *header = static_cast<const char *>(ptr) - HEADER_SIZE;
+        size_t arenaOffset = 0;
+        for (const HeapArena &arena : arenas)
+        {
+            if (header >= arena.base && header < arena.base + arena.size)
+            {
+                return arenaOffset + static_cast<size_t>(header - arena.base);
+            }
+            arenaOffset += arena.size;
+        }
+        return SIZE_MAX;
+    }
+
+    /**
+     * Whether an address lies inside one of the heap's arenas
+     */
+    bool Contains(const void *address) const
+    {
+        return FindArena(address) != nullptr;
+    }
+
+    /**
+     * Whether the heap lives in a backing file (see HeapConfig::backingFile)
+     */
+    bool IsFileBacked() const
+    {
+        return backingFd >= 0;
+    }
+
+    /**
+     * Save the state of a file-backed heap and flush it to its file
+     *
+     * @return - True once the file holds the heap as it is now
+     *
+     * The destructor syncs too, so this is only needed to guard against
+     * a later crash. Not available for a private mapping.
+     */
+    bool Sync()
+    {
+        if (!IsFileBacked() || config.privateMapping)
+        {
+            if (verbose)
+                std::cout << "ERROR: Only a shared file-backed heap can be synced.\n";
+            return false;
+        }
+
+        SaveState(true);
+        bool flushed = FlushHeapFile();
+        HeapState()->clean = 0;
+        return flushed;
+    }
+
+    /**
+     * Capture the heap in a new heap file
+     *
+     * @param path - Checkpoint file (overwritten; not the backing file)
+     * @return - True if the whole checkpoint was written
+     *
+     * The checkpoint is a complete heap file in the state the heap is in
+     * now; this heap carries on unchanged. Open it with privateMapping to
+     * fork any number of what-if experiments from the same state without
+     * touching it: each one maps it copy-on-write in O(1). The file is
+     * cloned (reflinked) where the file system supports it, so taking a
+     * checkpoint of a shared heap costs no copy; otherwise the mapping is
+     * written out, leaving holes where pages were never touched.
+     */
+    bool Checkpoint(const std::string &path)
+    {
+        if (!IsFileBacked())
+        {
+            if (verbose)
+                std::cout << "ERROR: Only a file-backed heap can be checkpointed.\n";
+            return false;
+        }
+
+#ifdef _WIN32
+        (void)path;
+        return false;
+#else
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+        struct stat target;
+        struct stat source;
+        if (fd < 0 || fstat(fd, &target) != 0 || fstat(backingFd, &source) != 0 ||
+            (target.st_dev == source.st_dev && target.st_ino == source.st_ino) || ftruncate(fd, 0) != 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            if (verbose)
+                std::cout << "ERROR: Cannot write checkpoint file " << path << "\n";
+            return false;
+        }
+
+        SaveState(true);
+        bool written = false;
+#ifdef FICLONE
+        written = !config.privateMapping && FlushHeapFile() && ioctl(fd, FICLONE, backingFd) == 0;
+#endif
+        if (!written)
+        {
+            written = WriteSparse(fd) && ftruncate(fd, static_cast<off_t>(reservationSize)) == 0;
+        }
+        HeapState()->clean = 0;
+
+        if (close(fd) != 0 || !written)
+        {
+            if (verbose)
+                std::cout << "ERROR: Cannot write checkpoint file " << path << "\n";
+            return false;
+        }
+        return true;
+#endif
+    }
+
+private:
+    // One report line for a histogram: count, mean and tail percentiles
+    static void PrintHistogram(const char *label, const LogHistogram &histogram, const char *unit)
+    {
+        std::cout << label << ": " << histogram.total << " samples, mean " << std::fixed
+                  << std::setprecision(1) << histogram.Mean() << ", p50 " << histogram.Percentile(0.50)
+                  << ", p99 " << histogram.Percentile(0.99) << ", p99.9 " << histogram.Percentile(0.999)
+                  << ", max " << histogram.maxValue << " " << unit << "\n";
+    }
+
+    // Allocate a group one block at a time, rolling back on failure
+    bool AllocateEach(const std::vector<size_t> &sizes, std::vector<void *> &out)
+    {
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            if (sizes[i] == 0)
+                continue;
+
+            out[i] = Allocate(sizes[i]);
+            if (!out[i])
+            {
+                for (size_t j = 0; j < i; j++)
+                {
+                    if (out[j])
+                    {
+                        Deallocate(out[j]);
+                    }
+                }
+                out.assign(sizes.size(), nullptr);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Payload size of the block that would serve a request
+    size_t BlockSizeFor(size_t size) const
+    {
+        size = AlignSize(std::max(size, MinBlock));
+        if (IsBuddy())
+        {
+            size_t order = std::max(CeilLog2(size + HEADER_SIZE), BUDDY_MIN_ORDER);
+            return (size_t(1) << order) - HEADER_SIZE;
+        }
+        return size;
+    }
+
+    // Whether no heap this allocator may grow to can hold a request; checked
+    // before the size is rounded, so that the rounding cannot wrap around
+    bool RequestTooLarge(size_t size) const
+    {
+        return size > MAX_ARENA_SIZE || size > config.maxHeapSize || (!config.growable && size > heapSize);
+    }
+
+    // Round a payload size up so that the whole block (header included)
+    // spans a multiple of Alignment
+    static constexpr size_t AlignSize(size_t size)
+    {
+        return ((size + HEADER_SIZE + Alignment - 1) & ~(Alignment - 1)) - HEADER_SIZE;
+    }
+
+    // Buddy layout and buddy frees are in use (a constant for fixed policies)
+    bool IsBuddy() const
+    {
+        return FitPolicy::RUNTIME ? strategy == AllocationStrategy::BUDDY
+                                  : FitPolicy::STRATEGY == AllocationStrategy::BUDDY;
+    }
+
+    // Alignment every payload gets without padding: buddy blocks start on
+    // a multiple of their size, so theirs is set by the payload offset
+    // within the page-aligned mapping
+    size_t NaturalAlignment() const
+    {
+        constexpr size_t payloadOffset = ARENA_PAD + HEADER_SIZE;
+        return IsBuddy() ? std::max(Alignment, payloadOffset & (~payloadOffset + 1)) : Alignment;
+    }
+
+    // Round a byte count up to whole pages
+    static size_t RoundToPage(size_t bytes)
+    {
+        return (bytes + HEAP_PAGE_SIZE - 1) & ~(HEAP_PAGE_SIZE - 1);
+    }
+
+    // Reserve a new arena and lay it out as free space
+    /**
+     * Arena Creation
+     *
+     * Reserves size bytes plus room for the end marker, then lays the
+     * arena out as free blocks for the current strategy. Fails (returns
+     * false) if the OS refuses the reservation.
+     */
+    bool AddArena(size_t size)
+    {
+        HeapArena arena;
+        arena.size = size;
+        arena.mappedSize = RoundToPage(ARENA_PAD + size + HEADER_SIZE);
+        char *mapping = MapArena(arena.mappedSize);
+        if (!mapping)
+        {
+            return false;
+        }
+        arena.base = mapping + ARENA_PAD;
+
+        // Keep arenas in address order, so "lowest address" (First Fit and
+        // the treap's tie-break) matches the order blocks are walked in
+        auto position = std::upper_bound(arenas.begin(), arenas.end(), arena,
+                                         [](const HeapArena &a, const HeapArena &b)
+                                         { return a.base < b.base; });
+        arenas.insert(position, arena);
+        heapSize += size;
+        totalFree += size - HEADER_SIZE;
+        LayoutEmptyArena(arena);
+        return true;
+    }
+
+    // Reserve the address space of a new arena
+    /**
+     * Arena Mapping
+     *
+     * With full headers every arena is its own mapping. Compact headers
+     * link blocks by 32-bit offsets, so every arena is carved from one
+     * reservation of up to COMPACT_HEAP_LIMIT bytes (all of it when the
+     * heap may grow, else just the initial arena); the pages are still
+     * committed on first touch. A file-backed heap carves its arena from
+     * the file mapping the same way.
+     */
+    char *MapArena(size_t bytes)
+    {
+        if (!reservation && !COMPACT_HEADERS)
+        {
+            return ReserveHeapMemory(bytes, config.hugePages);
+        }
+
+        if (!reservation)
+        {
+            size_t limit = config.growable ? COMPACT_HEAP_LIMIT : std::min(bytes, COMPACT_HEAP_LIMIT);
+            reservation = ReserveHeapMemory(limit, config.hugePages);
+            if (!reservation)
+            {
+                return nullptr;
+            }
+            reservationSize = limit;
+        }
+
+        if (bytes > reservationSize - reservationUsed)
+        {
+            return nullptr;
+        }
+        char *mapping = reservation + reservationUsed;
+        reservationUsed += bytes;
+        return mapping;
+    }
+
+    // Open (or create) the heap held by the backing file
+    /**
+     * Persistent Heaps
+     *
+     * A heap file is a state page (HeapFileState) followed by one arena,
+     * and the whole file is mapped as the heap's reservation. Sizes and
+     * boundary tags are relative, but full-layout free-block links are
+     * plain addresses (so anonymous heaps never pay for persistence): an
+     * existing file is mapped with the address it was saved at as a hint,
+     * and is reopened by reading the state page back, with no walk over
+     * its blocks, when the hint is honoured. Otherwise one pass over the
+     * arena shifts the links of the free blocks. A new file is sized and
+     * laid out like an anonymous arena. The state page is written when the heap is
+     * synced, checkpointed or destroyed, and marked stale while the file
+     * is open, so a heap whose process died is refused rather than trusted.
+     *
+     * Handles are not saved: after a reopen their blocks stay allocated
+     * but can no longer be resolved or moved by Compact.
+     */
+    bool OpenBackingFile()
+    {
+#ifdef _WIN32
+        if (verbose)
+            std::cout << "ERROR: File-backed heaps are not supported on this platform.\n";
+        return false;
+#else
+        const std::string &path = config.backingFile;
+        config.growable = false; // The file holds exactly one arena
+
+        backingFd = open(path.c_str(), config.privateMapping ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        struct stat info;
+        if (backingFd < 0 || fstat(backingFd, &info) != 0)
+        {
+            if (verbose)
+                std::cout << "ERROR: Cannot open heap file " << path << "\n";
+            CloseBackingFile();
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        bool create = fileSize == 0 && !config.privateMapping;
+
+        // Ask for the address the heap was saved at, so its links hold
+        uint64_t savedAt = 0;
+        if (!create && pread(backingFd, &savedAt, sizeof(savedAt), offsetof(HeapFileState, mappedAt)) != sizeof(savedAt))
+        {
+            savedAt = 0;
+        }
+        if (create)
+        {
+            fileSize = HEAP_FILE_STATE_BYTES + RoundToPage(ARENA_PAD + config.heapSize + HEADER_SIZE);
+            if (ftruncate(backingFd, static_cast<off_t>(fileSize)) != 0)
+            {
+                if (verbose)
+                    std::cout << "ERROR: Cannot size heap file " << path << "\n";
+                CloseBackingFile();
+                return false;
+            }
+        }
+
+        if (fileSize < HEAP_FILE_STATE_BYTES || (COMPACT_HEADERS && fileSize > COMPACT_HEAP_LIMIT) ||
+            !(reservation = MapHeapFile(backingFd, fileSize, config.privateMapping,
+                                        reinterpret_cast<void *>(static_cast<uintptr_t>(savedAt)))))
+        {
+            if (verbose)
+                std::cout << "ERROR: Cannot map heap file " << path << "\n";
+            CloseBackingFile();
+            return false;
+        }
+        reservationSize = fileSize;
+        reservationUsed = HEAP_FILE_STATE_BYTES;
+
+        if (create ? !AddArena(config.heapSize) : !RestoreState())
+        {
+            CloseBackingFile();
+            return false;
+        }
+
+        if (create)
+        {
+            SaveState(false);
+        }
+        else if (!config.privateMapping)
+        {
+            HeapState()->clean = 0;
+        }
+        return true;
+#endif
+    }
+
+    // Undo a partly opened backing file
+    void CloseBackingFile()
+    {
+#ifndef _WIN32
+        if (reservation)
+        {
+            ReleaseHeapMemory(reservation, reservationSize);
+        }
+        if (backingFd >= 0)
+        {
+            close(backingFd);
+        }
+#endif
+        arenas.clear();
+        reservation = nullptr;
+        backingFd = -1;
+    }
+
+#ifndef _WIN32
+    // Copy the mapping into a file, skipping all-zero chunks (left as holes)
+    bool WriteSparse(int fd) const
+    {
+        constexpr size_t CHUNK = 16 * HEAP_PAGE_SIZE;
+        for (size_t offset = 0; offset < reservationSize; offset += CHUNK)
+        {
+            size_t bytes = std::min(CHUNK, reservationSize - offset);
+            const uint64_t *words = reinterpret_cast<const uint64_t *>(reservation + offset);
+            if (std::all_of(words, words + bytes / sizeof(uint64_t), [](uint64_t word) { return word == 0; }))
+            {
+                continue;
+            }
+
+            for (size_t done = 0; done < bytes;)
+            {
+                ssize_t chunk = pwrite(fd, reservation + offset + done, bytes - done, static_cast<off_t>(offset + done));
+                if (chunk <= 0)
+                    return false;
+                done += static_cast<size_t>(chunk);
+            }
+        }
+        return true;
+    }
+#endif
+
+    // Flush the shared mapping of a heap file to the file
+    bool FlushHeapFile()
+    {
+#ifdef _WIN32
+        return false;
+#else
+        return msync(reservation, reservationSize, MS_SYNC) == 0;
+#endif
+    }
+
+    // The state page of a file-backed heap
+    HeapFileState *HeapState() const
+    {
+        return reinterpret_cast<HeapFileState *>(reservation);
+    }
+
+    // Pointer <-> offset from the start of the heap file (0 = nullptr)
+    uint64_t FileOffset(const void *ptr) const
+    {
+        return ptr ? static_cast<uint64_t>(static_cast<const char *>(ptr) - reservation) : 0;
+    }
+
+    template <typename T>
+    T *AtFileOffset(uint64_t offset) const
+    {
+        return offset ? reinterpret_cast<T *>(reservation + offset) : nullptr;
+    }
+
+    // Write the engine's state into the state page
+    void SaveState(bool clean)
+    {
+        HeapFileState &state = *HeapState();
+        std::memcpy(state.magic, HEAP_FILE_MAGIC, sizeof(state.magic));
+        state.version = HEAP_FILE_VERSION;
+        state.headerSize = static_cast<uint32_t>(HEADER_SIZE);
+        state.alignment = Alignment;
+        state.minBlock = MinBlock;
+        state.strategy = static_cast<uint32_t>(strategy);
+        state.clean = clean ? 1 : 0;
+        state.arenaSize = arenas.front().size;
+        state.mappedAt = reinterpret_cast<uintptr_t>(reservation);
+        state.totalAllocated = totalAllocated;
+        state.totalFree = totalFree;
+        state.allocatedBlocks = allocatedBlocks;
+        state.freeBlocks = freeBlocks;
+        state.largestFreeBlock = largestFreeBlock;
+        state.internalFragmentation = internalFragmentation;
+        state.searches = searches;
+        state.blocksVisited = blocksVisited;
+        state.reallocsInPlace = reallocsInPlace;
+        state.reallocsMoved = reallocsMoved;
+        state.blocksRelocated = blocksRelocated;
+        state.bytesRelocated = bytesRelocated;
+        state.binMap = binMap;
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        {
+            state.freeBins[i] = FileOffset(freeBins[i]);
+        }
+        state.freeTreeRoot = FileOffset(freeTreeRoot);
+        state.nextFitRover = FileOffset(nextFitRover);
+        state.compactCursor = FileOffset(compactCursor);
+        state.freeHistogram = freeHistogram;
+    }
+
+    // Adopt the state saved in the state page (O(1) unless the links must
+    // be shifted or the block index rebuilt)
+    bool RestoreState()
+    {
+        const HeapFileState &state = *HeapState();
+        size_t strategies = sizeof(ALL_STRATEGIES) / sizeof(ALL_STRATEGIES[0]);
+        size_t room = reservationSize - reservationUsed;
+
+        // Saved pointers must land in the arena (the rover and the cursor
+        // may also rest on its end marker); the size is bounded before it
+        // is rounded, so a corrupt one cannot wrap around
+        uint64_t arenaStart = reservationUsed + ARENA_PAD;
+        auto inArena = [&](uint64_t offset, bool endAllowed) {
+            return offset == 0 ||
+                   (offset >= arenaStart && (offset - arenaStart < state.arenaSize ||
+                                             (endAllowed && offset - arenaStart == state.arenaSize)));
+        };
+        bool offsetsValid = inArena(state.freeTreeRoot, false) && inArena(state.nextFitRover, true) &&
+                            inArena(state.compactCursor, true);
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        {
+            offsetsValid = offsetsValid && inArena(state.freeBins[i], false);
+        }
+
+        if (std::memcmp(state.magic, HEAP_FILE_MAGIC, sizeof(state.magic)) != 0 ||
+            state.version != HEAP_FILE_VERSION || state.headerSize != HEADER_SIZE ||
+            state.alignment != Alignment || state.minBlock != MinBlock || state.strategy >= strategies ||
+            (!FitPolicy::RUNTIME && static_cast<AllocationStrategy>(state.strategy) != FitPolicy::STRATEGY) ||
+            state.arenaSize == 0 || state.arenaSize % HEAP_PAGE_SIZE != 0 ||
+            room < ARENA_PAD + HEADER_SIZE || state.arenaSize > room - ARENA_PAD - HEADER_SIZE ||
+            RoundToPage(ARENA_PAD + state.arenaSize + HEADER_SIZE) > room || !offsetsValid)
+        {
+            if (verbose)
+                std::cout << "ERROR: " << config.backingFile << " is not a heap file for this allocator.\n";
+            return false;
+        }
+        if (!state.clean)
+        {
+            if (verbose)
+                std::cout << "ERROR: Heap file " << config.backingFile << " was not closed cleanly.\n";
+            return false;
+        }
+
+        HeapArena arena;
+        arena.base = reservation + reservationUsed + ARENA_PAD;
+        arena.size = state.arenaSize;
+        arena.mappedSize = RoundToPage(ARENA_PAD + arena.size + HEADER_SIZE);
+        arenas.push_back(arena);
+        reservationUsed += arena.mappedSize;
+        heapSize = arena.size;
+        config.heapSize = arena.size;
+
+        strategy = static_cast<AllocationStrategy>(state.strategy);
+        totalAllocated = state.totalAllocated;
+        totalFree = state.totalFree;
+        allocatedBlocks = state.allocatedBlocks;
+        freeBlocks = state.freeBlocks;
+        largestFreeBlock = state.largestFreeBlock;
+        internalFragmentation = state.internalFragmentation;
+        searches = state.searches;
+        blocksVisited = state.blocksVisited;
+        reallocsInPlace = state.reallocsInPlace;
+        reallocsMoved = state.reallocsMoved;
+        blocksRelocated = state.blocksRelocated;
+        bytesRelocated = state.bytesRelocated;
+        binMap = state.binMap;
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; i++)
+        {
+            freeBins[i] = AtFileOffset<MemoryBlock>(state.freeBins[i]);
+        }
+        freeTreeRoot = AtFileOffset<MemoryBlock>(state.freeTreeRoot);
+        nextFitRover = AtFileOffset<char>(state.nextFitRover);
+        compactCursor = AtFileOffset<MemoryBlock>(state.compactCursor);
+        freeHistogram = state.freeHistogram;
+
+        uintptr_t delta = reinterpret_cast<uintptr_t>(reservation) - static_cast<uintptr_t>(state.mappedAt);
+        bool shift = !COMPACT_HEADERS && delta != 0;
+        bool index = config.blockIndex && !IsBuddy();
+        if (!shift && !index)
+        {
+            return true;
+        }
+
+        // One pass over the blocks, each checked to end inside the arena
+        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(arena.base);
+        while (!block->IsEndMarker())
+        {
+            size_t left = static_cast<size_t>(arena.base + arena.size - reinterpret_cast<char *>(block));
+            if (left < HEADER_SIZE || block->Size() > left - HEADER_SIZE)
+            {
+                if (verbose)
+                    std::cout << "ERROR: " << config.backingFile << " is not a heap file for this allocator.\n";
+                return false;
+            }
+            if (!block->IsAllocated())
+            {
+                if (shift)
+                {
+                    block->ShiftLinks(delta);
+                }
+                if (index)
+                {
+                    freeIndex.Insert(IndexOffset(block), block->Size());
+                }
+            }
+            block = block->GetPhysicalNext();
+        }
+        return true;
+    }
+
+    // Add an arena large enough for a request that did not fit
+    /**
+     * Heap Growth
+     *
+     * Adds one arena of at least growthSize bytes that can hold the
+     * request on its own, as long as the heap is growable and stays
+     * within maxHeapSize.
+     */
+    bool GrowHeap(size_t size)
+    {
+        if (!config.growable)
+        {
+            return false;
+        }
+
+        // A buddy request needs a whole block of its order; any other
+        // request needs one block plus its header
+        size_t needed = size + HEADER_SIZE;
+        if (IsBuddy())
+        {
+            needed = size_t(1) << std::max(CeilLog2(needed), BUDDY_MIN_ORDER);
+        }
+
+        size_t arenaSize = std::max(config.growthSize, RoundToPage(needed));
+        if (heapSize >= config.maxHeapSize || arenaSize > config.maxHeapSize - heapSize)
+        {
+            return false;
+        }
+        return AddArena(arenaSize);
+    }
+
+    // Lay out an arena with no allocations as free blocks plus an end marker
+    /**
+     * Empty Arena Layout
+     *
+     * Fit strategies see the arena as one free block. Buddy allocation
+     * splits it into its binary decomposition - the largest power of two
+     * that fits, then the next, and so on - so every block is naturally
+     * aligned and finds its buddy by XOR within the arena.
+     */
+    void LayoutEmptyArena(const HeapArena &arena)
+    {
+        size_t offset = 0;
+        MemoryBlock *prev = nullptr;
+
+        while (offset < arena.size)
+        {
+            size_t blockBytes = arena.size - offset;
+            if (IsBuddy())
+            {
+                blockBytes = size_t(1) << FloorLog2(blockBytes);
+            }
+
+            MemoryBlock *block = reinterpret_cast<MemoryBlock *>(arena.base + offset);
+            InitBlock(block, blockBytes - HEADER_SIZE, false);
+            if (prev)
+            {
+                prev->StampBoundaryTag();
+            }
+            else
+            {
+                block->SetPrevTag(0); // The first block has no predecessor
+            }
+
+            if (IsBuddy())
+            {
+                PushBuddyBlock(block);
+            }
+            else
+            {
+                InsertFreeBlock(block);
+            }
+
+            freeBlocks++;
+            prev = block;
+            offset += blockBytes;
+        }
+
+        // Terminate the arena with an allocated, zero-sized end marker so
+        // forward coalescing stops there without a bounds check
+        MemoryBlock *endMarker = reinterpret_cast<MemoryBlock *>(arena.base + arena.size);
+        InitBlock(endMarker, 0, true);
+        prev->StampBoundaryTag();
+    }
+
+    // Find the arena containing an address, or nullptr
+    const HeapArena *FindArena(const void *address) const
+    {
+        const char *addr = static_cast<const char *>(address);
+        for (const HeapArena &arena : arenas)
+        {
+            if (addr >= arena.base && addr < arena.base + arena.size)
+            {
+                return &arena;
+            }
+        }
+        return nullptr;
+    }
+
+    // Find a free block for the request through the fit policy
+    MemoryBlock *FindFreeBlock(size_t size)
+    {
+        searches++;
+        if constexpr (INSTRUMENTATION_ENABLED)
+        {
+            size_t visitedBefore = blocksVisited;
+            MemoryBlock *block = FitPolicy::Find(*this, size);
+            counters.searchLength.Record(blocksVisited - visitedBefore);
+            return block;
+        }
+        return FitPolicy::Find(*this, size);
+    }
+
+    // Bump an instrumentation counter (compiled out when disabled)
+    static void Count(uint64_t &counter)
+    {
+        if constexpr (INSTRUMENTATION_ENABLED)
+        {
+            counter++;
+        }
+    }
+
+    // Find the first block that can fit the requested size
+    /**
+     * First Fit Algorithm
+     *
+     * Finds the free block with the lowest address that can accommodate the
+     * requested size. Only the bins that may hold a large enough block are
+     * visited: the size class of the request (whose blocks may still be too
+     * small) and every non-empty class above it (whose blocks always fit).
+     * Advantage: Never touches allocated blocks or free blocks that are too small
+     * Disadvantage: Must compare addresses across all candidate bins
+     *
+     * With HeapConfig::blockIndex the same block is found by scanning the
+     * FreeBlockIndex sizes in address order instead.
+     */
+    MemoryBlock *FindFirstFit(size_t size)
+    {
+        if (config.blockIndex && size < FreeBlockIndex::SATURATED)
+        {
+            return IndexedBlock(freeIndex.FindFirst(size, blocksVisited));
+        }
+
+        MemoryBlock *firstBlockFound = nullptr;
+
+        for (uint64_t bins = binMap & (~0ULL << SizeClass(size)); bins; bins &= bins - 1)
+        {
+            MemoryBlock *current = freeBins[FloorLog2(bins & (~bins + 1))];
+            while (current)
+            {
+                blocksVisited++;
+                if (current->Size() >= size && (!firstBlockFound || current < firstBlockFound))
+                {
+                    firstBlockFound = current;
+                }
+                current = Link(current, LINK_NEXT_FREE);
+            }
+        }
+        return firstBlockFound;
+    }
+
+    // Find the best fitting block for the requested size
+    /**
+     * Best Fit Algorithm
+     *
+     * Finds the smallest free block that can accommodate the requested size,
+     * preferring the lowest address among equal sizes (the same block the
+     * address-ordered scan would pick). Every block in a higher size class is
+     * larger than any fitting block of the request's own class, so the search
+     * stops at the first bin that contains a fit.
+     * Advantage: Minimizes wasted space per block
+     * Disadvantage: Scans a whole bin and can create many small fragments
+     *
+     * With HeapConfig::blockIndex the FreeBlockIndex is scanned instead
+     * (the bins take over only when the best block is too large for the
+     * index to tell apart from others).
+     */
+    MemoryBlock *FindBestFit(size_t size)
+    {
+        if (config.blockIndex && size < FreeBlockIndex::SATURATED)
+        {
+            size_t slot = freeIndex.FindBest(size, blocksVisited);
+            if (slot == FreeBlockIndex::NO_SLOT || freeIndex.SizeAt(slot) != FreeBlockIndex::SATURATED)
+            {
+                return IndexedBlock(slot);
+            }
+        }
+
+        for (uint64_t bins = binMap & (~0ULL << SizeClass(size)); bins; bins &= bins - 1)
+        {
+            MemoryBlock *bestBlock = nullptr;
+
+            MemoryBlock *current = freeBins[FloorLog2(bins & (~bins + 1))];
+            while (current)
+            {
+                blocksVisited++;
+                if (current->Size() >= size &&
+                    (!bestBlock || current->Size() < bestBlock->Size() ||
+                     (current->Size() == bestBlock->Size() && current < bestBlock)))
+                {
+                    bestBlock = current;
+                }
+                current = Link(current, LINK_NEXT_FREE);
+            }
+
+            if (bestBlock)
+            {
+                return bestBlock;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Find the first fitting block at or after the previous allocation
+    /**
+     * Next Fit Algorithm
+     *
+     * Finds the lowest-addressed fitting block at or after the address of
+     * the previous Next Fit allocation, wrapping around to the lowest
+     * fitting address overall when there is none.
+     * Advantage: Spreads allocations instead of crowding the heap start
+     * Disadvantage: Breaks up large blocks all over the heap
+     *
+     * The bins are not in address order, so without an index every block
+     * of every candidate bin is visited (as First Fit does), however close
+     * to the rover the answer lies. With HeapConfig::blockIndex the scan
+     * starts at the rover's slot in the FreeBlockIndex and stops at the
+     * first fit, wrapping around to the start of the index when needed.
+     */
+    MemoryBlock *FindNextFit(size_t size)
+    {
+        if (config.blockIndex && size < FreeBlockIndex::SATURATED)
+        {
+            size_t start = nextFitRover ? freeIndex.SlotFrom(IndexOffset(reinterpret_cast<MemoryBlock *>(nextFitRover))) : 0;
+            size_t slot = freeIndex.FindFirst(size, blocksVisited, start);
+            if (slot == FreeBlockIndex::NO_SLOT)
+            {
+                slot = freeIndex.FindFirst(size, blocksVisited, 0, start);
+            }
+
+            MemoryBlock *block = IndexedBlock(slot);
+            if (block)
+            {
+                nextFitRover = reinterpret_cast<char *>(block);
+            }
+            return block;
+        }
+
+        MemoryBlock *firstBlockFound = nullptr;
+        MemoryBlock *nextBlockFound = nullptr;
+
+        for (uint64_t bins = binMap & (~0ULL << SizeClass(size)); bins; bins &= bins - 1)
+        {
+            MemoryBlock *current = freeBins[FloorLog2(bins & (~bins + 1))];
+            while (current)
+            {
+                blocksVisited++;
+                if (current->Size() >= size)
+                {
+                    if (!firstBlockFound || current < firstBlockFound)
+                    {
+                        firstBlockFound = current;
+                    }
+                    if (reinterpret_cast<char *>(current) >= nextFitRover &&
+                        (!nextBlockFound || current < nextBlockFound))
+                    {
+                        nextBlockFound = current;
+                    }
+                }
+                current = Link(current, LINK_NEXT_FREE);
+            }
+        }
+
+        MemoryBlock *block = nextBlockFound ? nextBlockFound : firstBlockFound;
+        if (block)
+        {
+            nextFitRover = reinterpret_cast<char *>(block);
+        }
+        return block;
+    }
+
+    // Find the largest free block
+    /**
+     * Worst Fit Algorithm
+     *
+     * Takes the largest free block (lowest address among equal sizes),
+     * found through the treap in O(log n) expected time.
+     * Advantage: The split-off remainder is as large as possible
+     * Disadvantage: Quickly uses up the large blocks big requests need
+     */
+    MemoryBlock *FindWorstFit(size_t size)
+    {
+        if (largestFreeBlock < size)
+        {
+            return nullptr;
+        }
+        return FindTreeBestFit(largestFreeBlock);
+    }
+
+    // Find the best fitting block through the size-ordered treap
+    /**
+     * Tree Best Fit Algorithm
+     *
+     * Walks down the (size, address) treap, remembering the last node that
+     * was large enough and continuing left for a smaller one. The result is
+     * the minimum (size, address) among fitting blocks - exactly the block
+     * FindBestFit picks - in O(log n) expected time.
+     * Advantage: Logarithmic search regardless of the number of free blocks
+     * Disadvantage: Every free/split pays O(log n) to keep the treap updated
+     */
+    MemoryBlock *FindTreeBestFit(size_t size)
+    {
+        MemoryBlock *bestBlock = nullptr;
+
+        MemoryBlock *current = freeTreeRoot;
+        while (current)
+        {
+            blocksVisited++;
+            if (current->Size() >= size)
+            {
+                bestBlock = current;
+                current = Link(current, LINK_TREE_LEFT);
+            }
+            else
+            {
+                current = Link(current, LINK_TREE_RIGHT);
+            }
+        }
+
+        return bestBlock;
+    }
+
+    // Write a fresh header; the boundary tags around it are stamped by the caller
+    void InitBlock(MemoryBlock *block, size_t size, bool allocated)
+    {
+        block->Reset(size, allocated);
+        block->magic = BLOCK_MAGIC;
+        block->heapId = config.heapId;
+    }
+
+    // Split a block if it's larger than needed (plus minimum block size)
+    /**
+     * Block Splitting
+     *
+     * When a block is much larger than requested, splits it into two:
+     * 1. Allocated block (requested size)
+     * 2. New free block (remainder)
+     *
+     * This prevents wasting large amounts of free space in a single allocation.
+     */
+    void SplitBlock(MemoryBlock *block, size_t size)
+    {
+        if (!block)
+            return;
+
+        // Only split if the remainder would be large enough for another block
+        size_t remainingSize = block->Size() - size;
+        if (remainingSize < MinBlock + HEADER_SIZE)
+        {
+            return; // Don't split if remainder is too small
+        }
+
+        // Create a new block at the end of the current block's data area
+        char *blockEnd = reinterpret_cast<char *>(block->GetData()) + size;
+        MemoryBlock *newBlock = reinterpret_cast<MemoryBlock *>(blockEnd);
+
+        // Set up the new block
+        InitBlock(newBlock, remainingSize - HEADER_SIZE, false);
+
+        // Update the original block
+        block->SetSize(size);
+
+        // Fix the boundary tags of the new block and of the block after it
+        block->StampBoundaryTag();
+        newBlock->StampBoundaryTag();
+
+        // The remainder becomes available through its size-class bin
+        InsertFreeBlock(newBlock);
+
+        // Update statistics
+        freeBlocks++;
+        Count(counters.splits);
+    }
+
+    // Combine adjacent free blocks to reduce fragmentation
+    /**
+     * Block Coalescing (Merging)
+     *
+     * Combines adjacent free blocks to reduce fragmentation.
+     * Prevents creation of unusable tiny free blocks.
+     *
+     * Process:
+     * 1. Merge current block with next free block (forward coalescing)
+     * 2. Merge current block with previous free block (backward coalescing)
+     * 3. File the resulting block in the bin for its new size
+     */
+    void CoalesceBlocks(MemoryBlock *block)
+    {
+        if (!block)
+            return;
+
+        // Try to merge with the next block (if it's free)
+        // The end marker is always allocated, so this never runs off the heap
+        MemoryBlock *next = block->GetPhysicalNext();
+        if (!next->IsAllocated())
+        {
+            // The neighbour is absorbed, so it leaves its bin
+            RemoveFreeBlock(next);
+
+            // Calculate the combined size
+            block->SetSize(block->Size() + next->Size() + HEADER_SIZE);
+
+            // The absorbed header is no longer a block
+            next->magic = 0;
+            if (compactCursor == next)
+            {
+                compactCursor = block;
+            }
+
+            // Update statistics
+            freeBlocks--;
+            Count(counters.forwardCoalesces);
+        }
+
+        // Try to merge with the previous block (if it's free)
+        MemoryBlock *prev = block->GetPhysicalPrev();
+        if (prev && !prev->IsAllocated())
+        {
+            // The previous block grows, so it must move to a new bin
+            RemoveFreeBlock(prev);
+
+            // Calculate the combined size
+            prev->SetSize(prev->Size() + block->Size() + HEADER_SIZE);
+
+            // The absorbed header is no longer a block
+            block->magic = 0;
+            if (compactCursor == block)
+            {
+                compactCursor = prev;
+            }
+
+            // Update statistics
+            freeBlocks--;
+            Count(counters.backwardCoalesces);
+
+            // Continue with the merged block
+            block = prev;
+        }
+
+        // Fix the boundary tag of the block after the merged one
+        block->StampBoundaryTag();
+
+        InsertFreeBlock(block);
+    }
+
+    // Resize an allocated block without moving it
+    /**
+     * In-Place Resize
+     *
+     * Growing first absorbs the physically next block if it is free and
+     * the two together are large enough. Either way the block is then
+     * split down to the new size, and a split-off tail coalesces with the
+     * free block after it. Returns false (changing nothing) if the block
+     * cannot grow in place.
+     */
+    bool ResizeInPlace(MemoryBlock *block, size_t size)
+    {
+        if (size > block->Size())
+        {
+            MemoryBlock *next = block->GetPhysicalNext();
+            if (next->IsAllocated() || block->Size() + HEADER_SIZE + next->Size() < size)
+            {
+                return false;
+            }
+
+            // Absorb the neighbour, as forward coalescing would
+            RemoveFreeBlock(next);
+            block->SetSize(block->Size() + next->Size() + HEADER_SIZE);
+            next->magic = 0;
+            if (compactCursor == next)
+            {
+                compactCursor = block;
+            }
+            block->StampBoundaryTag();
+
+            // Update statistics
+            freeBlocks--;
+            Count(counters.forwardCoalesces);
+        }
+
+        // Give back the tail; if it borders another free block, merge them
+        MemoryBlock *next = block->GetPhysicalNext();
+        SplitBlock(block, size);
+        MemoryBlock *tail = block->GetPhysicalNext();
+        if (tail != next && !tail->GetPhysicalNext()->IsAllocated())
+        {
+            RemoveFreeBlock(tail);
+            CoalesceBlocks(tail);
+        }
+        return true;
+    }
+
+    // Move a relocatable block down over the free block just before it
+    /**
+     * Block Sliding
+     *
+     * Moves the header and payload of block to the address of the free
+     * block before it, then lays out the free space behind the moved block
+     * and coalesces it with a free successor. Sizes do not change, so only
+     * the handle, the boundary tags and the free structures need updating.
+     * Returns the free block behind the moved one.
+     */
+    MemoryBlock *SlideBlock(MemoryBlock *hole, MemoryBlock *block, uint32_t slot)
+    {
+        size_t holeSize = hole->Size();
+        size_t prevTag = hole->PrevTag();
+        RemoveFreeBlock(hole);
+
+        char *oldAddr = reinterpret_cast<char *>(block);
+        std::memmove(hole, block, HEADER_SIZE + block->Size());
+        MemoryBlock *moved = hole;
+        moved->SetPrevTag(prevTag);
+
+        // The free space now follows the moved block
+        MemoryBlock *gap = moved->GetPhysicalNext();
+        if (oldAddr >= reinterpret_cast<char *>(gap) + HEADER_SIZE)
+        {
+            // The old header is inside the gap's payload; retire it
+            reinterpret_cast<MemoryBlock *>(oldAddr)->magic = 0;
+        }
+        InitBlock(gap, holeSize, false);
+        moved->StampBoundaryTag();
+        gap->StampBoundaryTag();
+        CoalesceBlocks(gap);
+
+        handleOwner.erase(block);
+        handleOwner.emplace(moved, slot);
+        handleSlots[slot].block = moved;
+
+        // Update statistics
+        blocksRelocated++;
+        bytesRelocated += moved->Size();
+
+        return gap;
+    }
+
+    // Live handle slot for a handle, or nullptr
+    HandleSlot *FindHandleSlot(MemoryHandle handle)
+    {
+        return const_cast<HandleSlot *>(static_cast<const BasicMemoryAllocator *>(this)->FindHandleSlot(handle));
+    }
+
+    const HandleSlot *FindHandleSlot(MemoryHandle handle) const
+    {
+        uint64_t index = (handle & 0xFFFFFFFFULL) - 1;
+        if (handle == NULL_HANDLE || index >= handleSlots.size())
+        {
+            return nullptr;
+        }
+
+        const HandleSlot &slot = handleSlots[index];
+        if (!slot.block || slot.generation != static_cast<uint32_t>(handle >> 32))
+        {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    // Free-block link of a block (see BlockLink)
+    MemoryBlock *Link(const MemoryBlock *block, BlockLink link) const
+    {
+        return block->GetLink(link, reservation);
+    }
+
+    void SetLink(MemoryBlock *block, BlockLink link, MemoryBlock *target)
+    {
+        block->SetLink(link, target, reservation);
+    }
+
+    // Position of a block in the FreeBlockIndex (its offset from the link base)
+    uint64_t IndexOffset(const MemoryBlock *block) const
+    {
+        return reinterpret_cast<uintptr_t>(block) - reinterpret_cast<uintptr_t>(reservation);
+    }
+
+    MemoryBlock *IndexedBlock(size_t slot) const
+    {
+        if (slot == FreeBlockIndex::NO_SLOT)
+            return nullptr;
+        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<uintptr_t>(reservation) + freeIndex.OffsetAt(slot));
+    }
+
+    // Size class (bin index) for a block or request size
+    static size_t SizeClass(size_t size)
+    {
+        return FloorLog2(size);
+    }
+
+    // Push a free block onto the head of its size-class bin
+    void LinkFreeBin(MemoryBlock *block)
+    {
+        size_t bin = SizeClass(block->Size());
+
+        SetLink(block, LINK_PREV_FREE, nullptr);
+        SetLink(block, LINK_NEXT_FREE, freeBins[bin]);
+        if (freeBins[bin])
+        {
+            SetLink(freeBins[bin], LINK_PREV_FREE, block);
+        }
+        freeBins[bin] = block;
+        binMap |= 1ULL << bin;
+
+        freeHistogram.blocks[bin]++;
+        freeHistogram.bytes[bin] += block->Size();
+    }
+
+    // Unlink a free block from its size-class bin
+    void UnlinkFreeBin(MemoryBlock *block)
+    {
+        size_t bin = SizeClass(block->Size());
+
+        if (Link(block, LINK_PREV_FREE))
+        {
+            SetLink(Link(block, LINK_PREV_FREE), LINK_NEXT_FREE, Link(block, LINK_NEXT_FREE));
+        }
+        else
+        {
+            freeBins[bin] = Link(block, LINK_NEXT_FREE);
+        }
+        if (Link(block, LINK_NEXT_FREE))
+        {
+            SetLink(Link(block, LINK_NEXT_FREE), LINK_PREV_FREE, Link(block, LINK_PREV_FREE));
+        }
+        SetLink(block, LINK_NEXT_FREE, nullptr);
+        SetLink(block, LINK_PREV_FREE, nullptr);
+
+        if (!freeBins[bin])
+        {
+            binMap &= ~(1ULL << bin);
+        }
+
+        freeHistogram.blocks[bin]--;
+        freeHistogram.bytes[bin] -= block->Size();
+    }
+
+    // Add a free block to its size-class bin and the treap
+    /**
+     * Free List Insertion
+     *
+     * Pushes a free block onto the bin for its size class, marks the
+     * bin as non-empty in the bitmap (O(1)) and indexes it in the
+     * (size, address) treap (O(log n)) and the FreeBlockIndex, if any.
+     */
+    void InsertFreeBlock(MemoryBlock *block)
+    {
+        LinkFreeBin(block);
+        if (config.blockIndex)
+        {
+            freeIndex.Insert(IndexOffset(block), block->Size());
+        }
+
+        SetLink(block, LINK_TREE_LEFT, nullptr);
+        SetLink(block, LINK_TREE_RIGHT, nullptr);
+        freeTreeRoot = TreapInsert(freeTreeRoot, block);
+
+        if (block->Size() > largestFreeBlock)
+        {
+            largestFreeBlock = block->Size();
+        }
+    }
+
+    // Remove a free block from its size-class bin and the treap
+    /**
+     * Free List Removal
+     *
+     * Unlinks a block from its bin (it must still carry the size it was
+     * inserted with), clears the bin's bit once it becomes empty and
+     * drops it from the treap and the FreeBlockIndex. O(log n).
+     */
+    void RemoveFreeBlock(MemoryBlock *block)
+    {
+        UnlinkFreeBin(block);
+        if (config.blockIndex)
+        {
+            freeIndex.Remove(IndexOffset(block));
+        }
+
+        freeTreeRoot = TreapRemove(freeTreeRoot, block);
+        SetLink(block, LINK_TREE_LEFT, nullptr);
+        SetLink(block, LINK_TREE_RIGHT, nullptr);
+
+        // Only losing the largest block changes the maximum; the treap's
+        // rightmost node is the new one (O(log n))
+        if (block->Size() == largestFreeBlock)
+        {
+            MemoryBlock *largest = freeTreeRoot;
+            while (largest && Link(largest, LINK_TREE_RIGHT))
+            {
+                largest = Link(largest, LINK_TREE_RIGHT);
+            }
+            largestFreeBlock = largest ? largest->Size() : 0;
+        }
+    }
+
+    // Order of a buddy block (its total size including the header is 2^order)
+    static size_t BuddyOrder(const MemoryBlock *block)
+    {
+        return FloorLog2(block->Size() + HEADER_SIZE);
+    }
+
+    // File a free buddy block on its order's free list
+    /**
+     * Buddy Free List Insertion
+     *
+     * Buddy blocks only use the size-class bins (no treap). The largest
+     * free block is always the head of the highest non-empty order, so it
+     * is refreshed from the bitmap in O(1).
+     */
+    void PushBuddyBlock(MemoryBlock *block)
+    {
+        LinkFreeBin(block);
+        UpdateBuddyLargest();
+    }
+
+    // Take a free buddy block off its order's free list
+    void PopBuddyBlock(MemoryBlock *block)
+    {
+        UnlinkFreeBin(block);
+        UpdateBuddyLargest();
+    }
+
+    // Largest free buddy block, from the highest non-empty order
+    void UpdateBuddyLargest()
+    {
+        largestFreeBlock = binMap ? freeBins[FloorLog2(binMap)]->Size() : 0;
+    }
+
+    // Allocate a block from the buddy system
+    /**
+     * Buddy Allocation
+     *
+     * Rounds the request (plus header) up to a power of two, takes a block
+     * from the smallest non-empty order that is large enough and halves it
+     * until it has the right order, filing each upper half as a free
+     * buddy. At most one split per order, so the cost is bounded by the
+     * arena size, not by the number of blocks.
+     */
+    MemoryBlock *AllocateBuddyBlock(size_t size)
+    {
+        size_t order = CeilLog2(size + HEADER_SIZE);
+        if (order < BUDDY_MIN_ORDER)
+        {
+            order = BUDDY_MIN_ORDER;
+        }
+        if (order > NUM_SIZE_CLASSES)
+        {
+            return nullptr;
+        }
+
+        // Orders live in bin (order - 1); find the first non-empty one
+        uint64_t bins = binMap & (~0ULL << (order - 1));
+        if (!bins)
+        {
+            return nullptr;
+        }
+
+        MemoryBlock *block = freeBins[FloorLog2(bins & (~bins + 1))];
+        PopBuddyBlock(block);
+        blocksVisited++;
+
+        SplitBuddyBlock(block, order);
+        return block;
+    }
+
+    // Split a buddy block down to an order, freeing the upper halves
+    void SplitBuddyBlock(MemoryBlock *block, size_t order)
+    {
+        for (size_t current = BuddyOrder(block); current > order; current--)
+        {
+            size_t half = size_t(1) << (current - 1);
+            MemoryBlock *buddy = reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(block) + half);
+
+            block->SetSize(half - HEADER_SIZE);
+            InitBlock(buddy, half - HEADER_SIZE, false);
+            block->StampBoundaryTag();
+            buddy->StampBoundaryTag();
+            PushBuddyBlock(buddy);
+
+            // Update statistics
+            freeBlocks++;
+            Count(counters.splits);
+        }
+    }
+
+    // Resize an allocated buddy block without moving it
+    /**
+     * In-Place Buddy Resize
+     *
+     * A smaller order splits the block and frees the upper halves. A larger
+     * order is possible while the block is the lower half at every level
+     * and each upper buddy is entirely free: those buddies are absorbed.
+     * Returns false (changing nothing) otherwise.
+     */
+    bool ResizeBuddyInPlace(MemoryBlock *block, size_t size)
+    {
+        size_t order = std::max(CeilLog2(size + HEADER_SIZE), BUDDY_MIN_ORDER);
+        size_t current = BuddyOrder(block);
+        if (order <= current)
+        {
+            SplitBuddyBlock(block, order);
+            return true;
+        }
+
+        // Check every level first, so a failed grow leaves the heap alone
+        const HeapArena *arena = FindArena(block);
+        size_t offset = static_cast<size_t>(reinterpret_cast<char *>(block) - arena->base);
+        for (size_t level = current; level < order; level++)
+        {
+            size_t buddyOffset = offset + (size_t(1) << level);
+            if ((offset & (size_t(1) << level)) != 0 ||
+                buddyOffset + (size_t(1) << level) > arena->size)
+            {
+                return false;
+            }
+
+            MemoryBlock *buddy = reinterpret_cast<MemoryBlock *>(arena->base + buddyOffset);
+            if (buddy->IsAllocated() || BuddyOrder(buddy) != level)
+            {
+                return false;
+            }
+        }
+
+        for (size_t level = current; level < order; level++)
+        {
+            MemoryBlock *buddy = reinterpret_cast<MemoryBlock *>(arena->base + offset + (size_t(1) << level));
+            PopBuddyBlock(buddy);
+            buddy->magic = 0;
+            block->SetSize((size_t(1) << (level + 1)) - HEADER_SIZE);
+
+            // Update statistics
+            freeBlocks--;
+        }
+        block->StampBoundaryTag();
+        return true;
+    }
+
+    // Return a block to the buddy system, merging with free buddies
+    /**
+     * Buddy Free
+     *
+     * A block of order k at arena offset x has its buddy at x XOR 2^k. While
+     * that buddy lies inside the arena, is free and is of the same order
+     * (not split further), the two are merged into one block of order k + 1.
+     * At most one merge per order, so O(log N) in the arena size.
+     */
+    void FreeBuddyBlock(MemoryBlock *block)
+    {
+        const HeapArena *arena = FindArena(block);
+
+        for (size_t order = BuddyOrder(block);; order++)
+        {
+            size_t offset = static_cast<size_t>(reinterpret_cast<char *>(block) - arena->base);
+            size_t buddyOffset = offset ^ (size_t(1) << order);
+            if (buddyOffset + (size_t(1) << order) > arena->size)
+            {
+                break; // Top of the arena's decomposition
+            }
+
+            MemoryBlock *buddy = reinterpret_cast<MemoryBlock *>(arena->base + buddyOffset);
+            if (buddy->IsAllocated() || buddy->Size() != block->Size())
+            {
+                break;
+            }
+
+            // Merge the pair into the lower-addressed block
+            PopBuddyBlock(buddy);
+            Count(buddy < block ? counters.backwardCoalesces : counters.forwardCoalesces);
+            if (buddy < block)
+            {
+                std::swap(block, buddy);
+            }
+            block->SetSize((size_t(1) << (order + 1)) - HEADER_SIZE);
+            buddy->magic = 0;
+
+            // Update statistics
+            freeBlocks--;
+        }
+
+        block->StampBoundaryTag();
+        PushBuddyBlock(block);
+    }
+
+    // Treap ordering: by size, then by address
+    static bool TreeLess(const MemoryBlock *a, const MemoryBlock *b)
+    {
+        return a->Size() < b->Size() || (a->Size() == b->Size() && a < b);
+    }
+
+    // Treap heap priority, derived from the block's offset from the link
+    // base (no extra storage, and unchanged when a heap file is remapped)
+    uint64_t TreePriority(const MemoryBlock *block) const
+    {
+        uint64_t x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(block) - reinterpret_cast<uintptr_t>(reservation));
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Insert a node into the treap rooted at root, returning the new root
+    /**
+     * Treap Insertion
+     *
+     * Descends by key until the new node's priority beats the current
+     * subtree root, then splits that subtree around the new node.
+     * O(log n) expected.
+     */
+    MemoryBlock *TreapInsert(MemoryBlock *root, MemoryBlock *node)
+    {
+        if (!root)
+            return node;
+
+        if (TreePriority(node) > TreePriority(root))
+        {
+            MemoryBlock *left = nullptr;
+            MemoryBlock *right = nullptr;
+            TreapSplit(root, node, left, right);
+            SetLink(node, LINK_TREE_LEFT, left);
+            SetLink(node, LINK_TREE_RIGHT, right);
+            return node;
+        }
+
+        if (TreeLess(node, root))
+        {
+            SetLink(root, LINK_TREE_LEFT, TreapInsert(Link(root, LINK_TREE_LEFT), node));
+        }
+        else
+        {
+            SetLink(root, LINK_TREE_RIGHT, TreapInsert(Link(root, LINK_TREE_RIGHT), node));
+        }
+        return root;
+    }
+
+    // Remove a node from the treap rooted at root, returning the new root
+    /**
+     * Treap Removal
+     *
+     * Finds the node by its (size, address) key and replaces it with the
+     * merge of its two subtrees. O(log n) expected.
+     */
+    MemoryBlock *TreapRemove(MemoryBlock *root, MemoryBlock *node)
+    {
+        if (!root)
+            return nullptr;
+
+        if (root == node)
+        {
+            return TreapMerge(Link(node, LINK_TREE_LEFT), Link(node, LINK_TREE_RIGHT));
+        }
+
+        if (TreeLess(node, root))
+        {
+            SetLink(root, LINK_TREE_LEFT, TreapRemove(Link(root, LINK_TREE_LEFT), node));
+        }
+        else
+        {
+            SetLink(root, LINK_TREE_RIGHT, TreapRemove(Link(root, LINK_TREE_RIGHT), node));
+        }
+        return root;
+    }
+
+    // Split a treap into the nodes ordered before and after key
+    void TreapSplit(MemoryBlock *root, const MemoryBlock *key, MemoryBlock *&left, MemoryBlock *&right)
+    {
+        if (!root)
+        {
+            left = nullptr;
+            right = nullptr;
+            return;
+        }
+
+        if (TreeLess(root, key))
+        {
+            MemoryBlock *rest = nullptr;
+            TreapSplit(Link(root, LINK_TREE_RIGHT), key, rest, right);
+            SetLink(root, LINK_TREE_RIGHT, rest);
+            left = root;
+        }
+        else
+        {
+            MemoryBlock *rest = nullptr;
+            TreapSplit(Link(root, LINK_TREE_LEFT), key, left, rest);
+            SetLink(root, LINK_TREE_LEFT, rest);
+            right = root;
+        }
+    }
+
+    // Merge two treaps where every key in left is ordered before every key in right
+    MemoryBlock *TreapMerge(MemoryBlock *left, MemoryBlock *right)
+    {
+        if (!left)
+            return right;
+        if (!right)
+            return left;
+
+        if (TreePriority(left) > TreePriority(right))
+        {
+            SetLink(left, LINK_TREE_RIGHT, TreapMerge(Link(left, LINK_TREE_RIGHT), right));
+            return left;
+        }
+
+        SetLink(right, LINK_TREE_LEFT, TreapMerge(left, Link(right, LINK_TREE_LEFT)));
+        return right;
+    }
+
+    // Check if a block pointer is valid
+    /**
+     * Block Validation
+     *
+     * Verifies that a pointer points to a valid block header in O(1):
+     * 1. Check if address is within memory bounds and aligned
+     * 2. Check the header's magic word
+     * 3. Check that the next block's boundary tag agrees with this size
+     * In debug mode (SetDebugValidation) the heap is also walked to
+     * confirm the block exists.
+     */
+    bool IsValidBlock(MemoryBlock *block) const
+    {
+        if (!block)
+            return false;
+
+        // Check if the block is within the memory bounds of an arena
+        // (the arena's end marker sits at base + size)
+        char *blockAddr = reinterpret_cast<char *>(block);
+        const HeapArena *arena = FindArena(blockAddr);
+        if (!arena)
+        {
+            return false;
+        }
+
+        // Headers only ever start on aligned offsets
+        if ((blockAddr - arena->base) % Alignment != 0)
+        {
+            return false;
+        }
+
+        // Check the canary, then that the block ends inside the heap and the
+        // boundary tag of the following block agrees with its size
+        if (block->magic != BLOCK_MAGIC || block->IsEndMarker() ||
+            block->Size() > static_cast<size_t>(arena->base + arena->size - blockAddr) - HEADER_SIZE ||
+            !block->BoundaryTagMatches())
+        {
+            return false;
+        }
+
+        if (!fullValidation)
+        {
+            return true;
+        }
+
+        // Debug mode: validate block by traversing its arena
+        MemoryBlock *current = reinterpret_cast<MemoryBlock *>(arena->base);
+        while (!current->IsEndMarker())
+        {
+            if (current == block)
+            {
+                return true;
+            }
+            current = current->GetPhysicalNext();
+        }
+
+        return false;
+    }
+};
+
+// Runtime-switchable allocator
+/**
+ * MemoryAllocator Class
+ *
+ * The engine with its strategy chosen at run time (and changeable with
+ * SetStrategy), as used by the interactive tool and the front-ends. Code
+ * that knows its strategy up front can use a fixed policy instead, e.g.
+ * BasicMemoryAllocator<BestFitPolicy>, and skip the per-call dispatch.
+ */
+class MemoryAllocator : public BasicMemoryAllocator<RuntimeFitPolicy>
+{
+public:
+    /**
+     * Constructor - Initialize the memory allocator
+     *
+     * @param strat - Allocation strategy (default: First Fit)
+     * @param heapConfig - Heap size and growth settings (default: fixed 1MB)
+     *
+     * Throws std::bad_alloc if the initial arena cannot be reserved.
+     */
+    MemoryAllocator(AllocationStrategy strat = AllocationStrategy::FIRST_FIT,
+                    const HeapConfig &heapConfig = HeapConfig())
+        : BasicMemoryAllocator(strat, heapConfig)
+    {
+    }
+};
+
+#endif // MEMORY_ALLOCATOR_H
@@ -21,576 +21,520 @@
  * ============================================================================
  */
 
+#include "memory_allocator.h"
+#include "slab_allocator.h"
+#include "trace_replay.h"
+#include "trace_sweep.h"
+#include "workload_generator.h"
+#include "engine_server.h"
+#include "heap_snapshot.h"
+
+#include <fstream>
 #include <iostream>
 #include <vector>
-#include <algorithm>
-#include <iomanip>
-#include <cstring>
+#include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <charconv>
 
-// Constants
-constexpr size_t MEMORY_SIZE = 1024 * 1024;        // 1MB virtual heap
-constexpr size_t MIN_BLOCK_SIZE = 16;              // Minimum block size (bytes)
-constexpr size_t HEADER_SIZE = sizeof(size_t) * 2; // Size for block header
-
-// Allocation strategies
+// Parse a byte count such as "4096", "64K", "512M" or "2G"
 /**
- * AllocationStrategy Enum
- *
- * FIRST_FIT: Allocates the first block that can accommodate the requested size.
- *            Simple and fast, but can lead to fragmentation.
+ * Size Parsing
  *
- * BEST_FIT: Finds the smallest block that can accommodate the requested size.
- *           Reduces wasted space but is slower and can create many small fragments.
+ * @param text - Decimal number with an optional K/M/G suffix (powers of 1024)
+ * @param bytes - Receives the parsed value
+ * @return - True if the whole string was a valid size
  */
-enum class AllocationStrategy
+bool ParseByteSize(const char *text, size_t &bytes)
 {
-    FIRST_FIT, // Use first available block
-    BEST_FIT   // Use smallest suitable block
-};
+    // strtoull would accept a sign (and wrap "-1" around) or leading spaces
+    if (*text < '0' || *text > '9')
+        return false;
+
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    if (errno == ERANGE)
+        return false;
+
+    unsigned shift = 0;
+    switch (*end)
+    {
+    case 'G':
+    case 'g':
+        shift += 10;
+        // fall through
+    case 'M':
+    case 'm':
+        shift += 10;
+        // fall through
+    case 'K':
+    case 'k':
+        shift += 10;
+        end++;
+        break;
+    default:
+        break;
+    }
+
+    if (*end != '\0' || value == 0 || value > (SIZE_MAX >> shift))
+        return false;
+    value <<= shift;
+
+    bytes = static_cast<size_t>(value);
+    return true;
+}
 
-// Memory block structure
 /**
- * MemoryBlock Structure
- *
- * Represents a block of memory (allocated or free) in the virtual heap.
- * Uses a doubly-linked list for efficient forward and backward traversal.
+ * Plain Number Parsing
  *
- * Members:
- *   - size: Size of the block in bytes (excluding header)
- *   - allocated: Flag indicating if block is in use
- *   - next/prev: Pointers for linked list navigation
+ * @param text - Unsigned decimal number, zero included, with no suffix
+ * @param value - Receives the parsed value
+ * @return - True if the whole string was a number that fits
  */
-struct MemoryBlock
+bool ParseUnsigned(const char *text, uint64_t &value)
 {
-    size_t size;       // Size of the block in bytes (excluding header)
-    bool allocated;    // Whether the block is allocated or free
-    MemoryBlock *next; // Pointer to next block in the linked list
-    MemoryBlock *prev; // Pointer to previous block in the linked list
-
-    // Get pointer to the data area of this block
-    // This moves the pointer past the header to actual usable memory
-    void *GetData()
-    {
-        return reinterpret_cast<void *>(reinterpret_cast<char *>(this) + HEADER_SIZE);
-    }
+    const char *end = text + std::strlen(text);
+    auto result = std::from_chars(text, end, value);
+    return result.ec == std::errc() && result.ptr == end && text != end;
+}
 
-    // Get pointer to the next block based on address arithmetic
-    // This calculates where the next block should be based on current block's size
-    MemoryBlock *GetPhysicalNext()
+/**
+ * Parse a comma-separated list of byte counts such as "256K,1M,4M"
+ *
+ * @param text - List of sizes accepted by ParseByteSize
+ * @param sizes - Receives the parsed values (replacing its contents)
+ * @return - True if every entry was a valid size
+ */
+bool ParseSizeList(const std::string &text, std::vector<size_t> &sizes)
+{
+    sizes.clear();
+    size_t begin = 0;
+    while (begin <= text.size())
     {
-        if (size == 0)
-            return nullptr; // End of memory
-        return reinterpret_cast<MemoryBlock *>(reinterpret_cast<char *>(GetData()) + size);
+        size_t end = std::min(text.find(',', begin), text.size());
+        size_t bytes = 0;
+        if (!ParseByteSize(text.substr(begin, end - begin).c_str(), bytes))
+            return false;
+        sizes.push_back(bytes);
+        begin = end + 1;
     }
-};
+    return !sizes.empty();
+}
 
-// Memory Allocator class
 /**
- * MemoryAllocator Class
+ * Parse a workload phase such as "events=1M,sizes=zipf,max=4K,life=fifo"
  *
- * This is the core class that simulates OS-level memory management.
- * It maintains a virtual heap, manages memory blocks, and provides
- * statistics about memory usage and fragmentation.
- *
- * Key Features:
- *   - Two allocation strategies (First Fit and Best Fit)
- *   - Automatic block splitting and coalescing
- *   - Memory fragmentation tracking
- *   - Detailed statistics and visualization
- *   - Safe deallocation with validation
+ * @param text - Comma-separated key=value fields: events, sizes (uniform,
+ *               zipf, lognormal or bimodal), min, max, shape, life (lifo,
+ *               fifo, exponential or outliers), live, mean and outliers;
+ *               fields left out keep their WorkloadPhase defaults
+ * @param phase - Receives the parsed phase
+ * @return - True if every field was valid
  */
-class MemoryAllocator
+bool ParseWorkloadPhase(const std::string &text, WorkloadPhase &phase)
 {
-private:
-    char memory[MEMORY_SIZE];    // The virtual heap (1MB simulated memory)
-    MemoryBlock *firstBlock;     // Start of the memory blocks linked list
-    AllocationStrategy strategy; // Current allocation strategy
-
-    // Statistics members - track memory usage patterns
-    size_t totalAllocated;   // Total bytes currently allocated
-    size_t totalFree;        // Total bytes currently free
-    size_t allocatedBlocks;  // Number of allocated blocks
-    size_t freeBlocks;       // Number of free blocks
-    size_t largestFreeBlock; // Size of largest contiguous free block
-    double fragmentation;    // Fragmentation ratio (0.0 = no fragmentation)
-
-public:
-    /**
-     * Constructor - Initialize the memory allocator
-     *
-     * @param strat - Allocation strategy (default: First Fit)
-     *
-     * Sets up the virtual memory heap with one large free block
-     * covering the entire 1MB space. Initializes all statistics.
-     */
-    MemoryAllocator(AllocationStrategy strat = AllocationStrategy::FIRST_FIT)
-        : strategy(strat), totalAllocated(0), totalFree(MEMORY_SIZE - HEADER_SIZE),
-          allocatedBlocks(0), freeBlocks(1), largestFreeBlock(MEMORY_SIZE - HEADER_SIZE),
-          fragmentation(0.0)
+    size_t begin = 0;
+    while (begin < text.size())
     {
+        size_t end = std::min(text.find(',', begin), text.size());
+        std::string field = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t equals = field.find('=');
+        if (equals == std::string::npos)
+            return false;
+        std::string key = field.substr(0, equals);
+        std::string value = field.substr(equals + 1);
+
+        size_t count = 0;
+        char *rest = nullptr;
+        double number = std::strtod(value.c_str(), &rest);
+        bool isNumber = !value.empty() && *rest == '\0' && number >= 0;
+        bool valid;
+        if (key == "events")
+        {
+            valid = ParseByteSize(value.c_str(), count);
+            phase.events = count;
+        }
+        else if (key == "sizes")
+            valid = ParseSizeDistribution(value, phase.sizes);
+        else if (key == "min")
+            valid = ParseByteSize(value.c_str(), phase.minSize);
+        else if (key == "max")
+            valid = ParseByteSize(value.c_str(), phase.maxSize);
+        else if (key == "shape")
+            valid = isNumber && (phase.shape = number, true);
+        else if (key == "life")
+            valid = ParseLifetimeModel(value, phase.lifetime);
+        else if (key == "live")
+            valid = ParseByteSize(value.c_str(), phase.liveTarget);
+        else if (key == "mean")
+            valid = isNumber && number > 0 && (phase.meanLifetime = number, true);
+        else if (key == "outliers")
+            valid = isNumber && number <= 1 && (phase.outlierRate = number, true);
+        else
+            valid = false;
 
-        // Initialize the first block (entire memory is free)
-        firstBlock = reinterpret_cast<MemoryBlock *>(memory);
-        firstBlock->size = MEMORY_SIZE - HEADER_SIZE;
-        firstBlock->allocated = false;
-        firstBlock->next = nullptr;
-        firstBlock->prev = nullptr;
+        if (!valid)
+            return false;
     }
+    return phase.minSize <= phase.maxSize;
+}
 
-    /**
-     * Set allocation strategy
-     *
-     * @param strat - New allocation strategy to use
-     */
-    void SetStrategy(AllocationStrategy strat)
+/**
+ * Replay a decoded trace for every strategy, heap size and minimum block
+ * size, and print the comparison table
+ */
+void RunSweep(const DecodedTrace &trace, std::vector<size_t> heapSizes, const std::vector<size_t> &minBlocks,
+              const HeapConfig &heapConfig, size_t threads)
+{
+    if (heapSizes.empty())
     {
-        strategy = strat;
+        heapSizes.push_back(heapConfig.heapSize);
     }
 
-    /**
-     * Allocate memory block
-     *
-     * @param size - Number of bytes to allocate
-     * @return - Pointer to allocated memory, or nullptr if allocation failed
-     *
-     * Finds a suitable free block using the selected strategy, splits it
-     * if necessary, and returns a pointer to the usable data area.
-     */
-    void *Allocate(size_t size)
+    std::vector<AllocationStrategy> strategies(std::begin(ALL_STRATEGIES), std::end(ALL_STRATEGIES));
+    TraceSweeper sweeper(trace);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = sweeper.Run(strategies, heapSizes, minBlocks, heapConfig, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TraceSweeper::PrintSweepReport(results);
+    std::cout << results.size() << " runs of " << trace.events.size() << " events in "
+              << std::fixed << std::setprecision(3) << seconds << " s\n";
+}
+
+// Main function with user interaction
+/**
+ * Main Function - Interactive Tutorial Interface
+ *
+ * Provides an interactive menu-driven interface where users can:
+ * 1. Manually allocate and deallocate memory
+ * 2. Switch between allocation strategies
+ * 3. View memory statistics and visualization
+ * 4. Run an automated demonstration
+ * 5. Route small allocations through the slab front-end
+ *
+ * This allows hands-on learning of memory management concepts.
+ *
+ * Command-line options configure the heap:
+ *   --heap-size=SIZE  Size of the initial arena (default 1M)
+ *   --grow            Add arenas when an allocation does not fit
+ *   --max-heap=SIZE   Cap on the total heap size when growing (at least
+ *                     --heap-size)
+ *   --huge-pages      Advise transparent huge pages for the arenas
+ *   --block-index     Run First, Best and Next Fit as SIMD scans over an
+ *                     out-of-band free-block index (same choices)
+ *   --strategy=NAME   Initial strategy: first, best, tree, buddy, next or worst
+ *   --slab            Start with the slab front-end enabled
+ *   --heap-file=FILE  Keep the heap in FILE: a heap already in it is
+ *                     reopened as it was left (with its own size and
+ *                     strategy), otherwise a new one is created
+ *   --private         Map the heap file copy-on-write, leaving it untouched
+ *
+ * With --replay=FILE (or --replay=- for stdin) no menu is shown: the trace
+ * is streamed through the allocator and only a summary is printed (see
+ * trace_replay.h for the format). --snapshot=FILE then also writes a binary
+ * snapshot of the heap as the trace left it (see heap_snapshot.h), and
+ * --timeline=FILE samples fragmentation every --sample-every=N events
+ * (default 1000) into a CSV file. With a heap file the blocks still live
+ * at the end stay allocated in it, and --checkpoint=FILE saves the heap
+ * the run left behind as a new heap file, to be reopened with
+ * --heap-file=FILE --private for what-if runs from that state.
+ *
+ * With --sweep the trace is instead replayed once for every strategy, heap
+ * size (--sweep-heaps=LIST, default --heap-size) and minimum block size
+ * (--sweep-min-blocks=LIST of 16, 32, 64, 128 or 256, default 16) on
+ * --threads=N worker threads (default one per hardware thread), and a
+ * comparison table is printed (see trace_sweep.h); a sweep does not use
+ * a heap file.
+ *
+ * Each --phase=SPEC adds a phase of a synthetic workload instead (see
+ * workload_generator.h and ParseWorkloadPhase), generated from --seed=N
+ * (default 1); --drain frees the live blocks after the last phase. The
+ * workload runs through the allocator like a replayed trace, is swept with
+ * --sweep, or is written as a trace with --write-trace=FILE (or - for
+ * stdout).
+ *
+ * With --serve the tool runs as the engine process of the web front-end,
+ * answering line commands on stdin (see engine_server.h).
+ */
+int main(int argc, char *argv[])
+try
+{
+    // Parse heap configuration options
+    HeapConfig heapConfig;
+    AllocationStrategy currentStrategy = AllocationStrategy::FIRST_FIT;
+    bool slabEnabled = false;
+    std::string replayPath;
+    std::string snapshotPath;
+    std::string timelinePath;
+    size_t sampleEvery = 1000;
+    bool serve = false;
+    bool sweep = false;
+    std::vector<size_t> sweepHeaps;
+    std::vector<size_t> sweepMinBlocks = {MIN_BLOCK_SIZE};
+    size_t threads = 0;
+    std::vector<WorkloadPhase> phases;
+    uint64_t seed = 1;
+    bool drain = false;
+    std::string writeTracePath;
+    std::string checkpointPath;
+    for (int i = 1; i < argc; i++)
     {
-        if (size == 0)
-            return nullptr;
+        std::string arg = argv[i];
+        bool valid = true;
 
-        // Round up size to minimum block size if needed
-        if (size < MIN_BLOCK_SIZE)
+        if (arg.rfind("--heap-size=", 0) == 0)
         {
-            size = MIN_BLOCK_SIZE;
+            valid = ParseByteSize(arg.c_str() + 12, heapConfig.heapSize);
         }
-
-        // Find a suitable block using the selected strategy
-        MemoryBlock *block = nullptr;
-
-        if (strategy == AllocationStrategy::FIRST_FIT)
+        else if (arg.rfind("--max-heap=", 0) == 0)
         {
-            block = FindFirstFit(size);
+            valid = ParseByteSize(arg.c_str() + 11, heapConfig.maxHeapSize);
         }
-        else
-        { // BEST_FIT
-            block = FindBestFit(size);
+        else if (arg == "--grow")
+        {
+            heapConfig.growable = true;
         }
-
-        if (!block)
+        else if (arg == "--huge-pages")
         {
-            std::cout << "ERROR: Memory allocation failed. Not enough free memory.\n";
-            return nullptr;
+            heapConfig.hugePages = true;
         }
-
-        // Split the block if needed
-        SplitBlock(block, size);
-
-        // Mark block as allocated
-        block->allocated = true;
-
-        // Update statistics
-        totalAllocated += block->size;
-        totalFree -= block->size;
-        allocatedBlocks++;
-        freeBlocks--;
-        UpdateStats();
-
-        return block->GetData();
-    }
-
-    /**
-     * Deallocate memory block
-     *
-     * @param ptr - Pointer to previously allocated memory
-     * @return - True if deallocation succeeded, false otherwise
-     *
-     * Marks a block as free and attempts to coalesce with adjacent
-     * free blocks to reduce fragmentation.
-     */
-    bool Deallocate(void *ptr)
-    {
-        if (!ptr)
-            return false;
-
-        // Calculate the block address from the data pointer
-        MemoryBlock *block = reinterpret_cast<MemoryBlock *>(
-            reinterpret_cast<char *>(ptr) - HEADER_SIZE);
-
-        // Validate the block
-        if (!IsValidBlock(block) || !block->allocated)
+        else if (arg == "--block-index")
         {
-            std::cout << "ERROR: Invalid deallocation request.\n";
-            return false;
+            heapConfig.blockIndex = true;
         }
-
-        // Mark block as free
-        block->allocated = false;
-
-        // Update statistics
-        totalAllocated -= block->size;
-        totalFree += block->size;
-        allocatedBlocks--;
-        freeBlocks++;
-
-        // Attempt to coalesce with adjacent blocks
-        CoalesceBlocks(block);
-        UpdateStats();
-
-        return true;
-    }
-
-    /**
-     * Print comprehensive memory usage report
-     *
-     * Shows:
-     *   - Total and available memory
-     *   - Number of allocated and free blocks
-     *   - Fragmentation percentage
-     *   - Current allocation strategy
-     */
-    void PrintMemoryReport() const
-    {
-        std::cout << "\n===== MEMORY ALLOCATOR REPORT =====\n";
-        std::cout << "Total Memory: " << MEMORY_SIZE << " bytes\n";
-        std::cout << "Allocation Strategy: " << (strategy == AllocationStrategy::FIRST_FIT ? "First Fit" : "Best Fit") << "\n";
-        std::cout << "Total Allocated: " << totalAllocated << " bytes ("
-                  << std::fixed << std::setprecision(2) << (totalAllocated * 100.0 / MEMORY_SIZE) << "%)\n";
-        std::cout << "Total Free: " << totalFree << " bytes ("
-                  << std::fixed << std::setprecision(2) << (totalFree * 100.0 / MEMORY_SIZE) << "%)\n";
-        std::cout << "Allocated Blocks: " << allocatedBlocks << "\n";
-        std::cout << "Free Blocks: " << freeBlocks << "\n";
-        std::cout << "Largest Free Block: " << largestFreeBlock << " bytes\n";
-        std::cout << "Memory Fragmentation: " << std::fixed << std::setprecision(2)
-                  << (fragmentation * 100.0) << "%\n";
-        std::cout << "==================================\n\n";
-    }
-
-    /**
-     * Print visual memory map
-     *
-     * Shows a text-based visualization of memory usage:
-     *   A = Allocated block
-     *   F = Free block
-     */
-    void PrintMemoryMap() const
-    {
-        std::cout << "\n===== MEMORY MAP =====\n";
-        std::cout << "Each symbol represents " << (MEMORY_SIZE / 100) << " bytes\n";
-        std::cout << "[A] = Allocated, [F] = Free\n";
-
-        MemoryBlock *current = firstBlock;
-        int symbolCount = 0;
-        int lineCount = 0;
-
-        while (current)
+        else if (arg.rfind("--strategy=", 0) == 0)
         {
-            size_t blockSymbols = current->size / (MEMORY_SIZE / 100);
-            if (blockSymbols == 0)
-                blockSymbols = 1;
-
-            for (size_t i = 0; i < blockSymbols; i++)
+            valid = ParseStrategy(arg.substr(11), currentStrategy);
+        }
+        else if (arg == "--slab")
+        {
+            slabEnabled = true;
+        }
+        else if (arg.rfind("--replay=", 0) == 0)
+        {
+            replayPath = arg.substr(9);
+            valid = !replayPath.empty();
+        }
+        else if (arg.rfind("--snapshot=", 0) == 0)
+        {
+            snapshotPath = arg.substr(11);
+            valid = !snapshotPath.empty();
+        }
+        else if (arg.rfind("--timeline=", 0) == 0)
+        {
+            timelinePath = arg.substr(11);
+            valid = !timelinePath.empty();
+        }
+        else if (arg.rfind("--sample-every=", 0) == 0)
+        {
+            valid = ParseByteSize(arg.c_str() + 15, sampleEvery);
+        }
+        else if (arg == "--serve")
+        {
+            serve = true;
+        }
+        else if (arg == "--sweep")
+        {
+            sweep = true;
+        }
+        else if (arg.rfind("--sweep-heaps=", 0) == 0)
+        {
+            valid = ParseSizeList(arg.substr(14), sweepHeaps);
+        }
+        else if (arg.rfind("--sweep-min-blocks=", 0) == 0)
+        {
+            valid = ParseSizeList(arg.substr(19), sweepMinBlocks);
+            for (size_t minBlock : sweepMinBlocks)
             {
-                std::cout << (current->allocated ? "A" : "F");
-                symbolCount++;
-
-                if (symbolCount % 50 == 0)
-                {
-                    std::cout << " " << (lineCount * 50 + 1) << "-" << (lineCount + 1) * 50 << "\n";
-                    lineCount++;
-                }
+                valid = valid && std::find(std::begin(SWEEP_MIN_BLOCKS), std::end(SWEEP_MIN_BLOCKS), minBlock) !=
+                                     std::end(SWEEP_MIN_BLOCKS);
             }
-
-            current = current->next;
         }
-
-        if (symbolCount % 50 != 0)
+        else if (arg.rfind("--threads=", 0) == 0)
         {
-            std::cout << " " << ((lineCount * 50) + 1) << "-" << symbolCount << "\n";
+            valid = ParseByteSize(arg.c_str() + 10, threads);
+        }
+        else if (arg.rfind("--phase=", 0) == 0)
+        {
+            phases.emplace_back();
+            valid = ParseWorkloadPhase(arg.substr(8), phases.back());
+        }
+        else if (arg.rfind("--seed=", 0) == 0)
+        {
+            valid = ParseUnsigned(arg.c_str() + 7, seed);
+        }
+        else if (arg == "--drain")
+        {
+            drain = true;
+        }
+        else if (arg.rfind("--write-trace=", 0) == 0)
+        {
+            writeTracePath = arg.substr(14);
+            valid = !writeTracePath.empty();
+        }
+        else if (arg.rfind("--heap-file=", 0) == 0)
+        {
+            heapConfig.backingFile = arg.substr(12);
+            valid = !heapConfig.backingFile.empty();
+        }
+        else if (arg == "--private")
+        {
+            heapConfig.privateMapping = true;
+        }
+        else if (arg.rfind("--checkpoint=", 0) == 0)
+        {
+            checkpointPath = arg.substr(13);
+            valid = !checkpointPath.empty();
+        }
+        else
+        {
+            valid = false;
         }
-        std::cout << "====================\n\n";
-    }
 
-    /**
-     * Print detailed block information
-     *
-     * Displays a table with information about each memory block
-     */
-    void PrintBlockDetails() const
-    {
-        std::cout << "\n===== BLOCK DETAILS =====\n";
-        std::cout << std::left << std::setw(20) << "Block Address"
-                  << std::setw(15) << "Size (bytes)"
-                  << std::setw(12) << "Status"
-                  << "Data Address\n";
-        std::cout << std::string(60, '-') << "\n";
-
-        MemoryBlock *current = firstBlock;
-        while (current)
-        {
-            std::cout << std::left << std::setw(20) << current
-                      << std::setw(15) << current->size
-                      << std::setw(12) << (current->allocated ? "Allocated" : "Free")
-                      << current->GetData() << "\n";
-            current = current->next;
-        }
-        std::cout << "=======================\n\n";
+        if (!valid)
+        {
+            std::cout << "Usage: " << argv[0]
+                      << " [--heap-size=SIZE] [--grow] [--max-heap=SIZE] [--huge-pages]\n"
+                      << "       [--strategy=first|best|tree|buddy|next|worst] [--slab] [--replay=FILE|-]\n"
+                      << "       [--snapshot=FILE] [--timeline=FILE] [--sample-every=N] [--serve]\n"
+                      << "       [--sweep] [--sweep-heaps=LIST] [--sweep-min-blocks=LIST] [--threads=N]\n"
+                      << "       [--phase=SPEC ...] [--seed=N] [--drain] [--write-trace=FILE|-]\n"
+                      << "       [--heap-file=FILE] [--private] [--checkpoint=FILE] [--block-index]\n"
+                      << "SIZE is a byte count with an optional K, M or G suffix.\n";
+            return 1;
+        }
     }
 
-private:
-    // Find the first block that can fit the requested size
-    /**
-     * First Fit Algorithm
-     *
-     * Finds the first free block that can accommodate the requested size.
-     * Advantage: Fast (O(n) worst case, often better in practice)
-     * Disadvantage: Can lead to fragmentation near the start
-     */
-    MemoryBlock *FindFirstFit(size_t size)
+    // Every sweep run builds its own heap, so none of them can own the file
+    if (sweep && (!heapConfig.backingFile.empty() || !checkpointPath.empty()))
     {
-        MemoryBlock *current = firstBlock;
-        while (current)
-        {
-            if (!current->allocated && current->size >= size)
-            {
-                return current;
-            }
-            current = current->next;
-        }
-        return nullptr;
+        std::cout << "ERROR: --sweep cannot be combined with --heap-file or --checkpoint.\n";
+        return 1;
     }
 
-    // Find the best fitting block for the requested size
-    /**
-     * Best Fit Algorithm
-     *
-     * Finds the smallest free block that can accommodate the requested size.
-     * Advantage: Minimizes wasted space per block
-     * Disadvantage: Slower (O(n) always) and creates many small fragments
-     */
-    MemoryBlock *FindBestFit(size_t size)
+    // Workload mode: generate a synthetic workload and run, sweep or save it
+    if (!phases.empty())
     {
-        MemoryBlock *bestBlock = nullptr;
-        size_t bestSize = MEMORY_SIZE + 1; // Initialize with a value larger than possible
+        WorkloadGenerator generator(phases, seed, drain);
 
-        MemoryBlock *current = firstBlock;
-        while (current)
+        if (!writeTracePath.empty())
         {
-            if (!current->allocated && current->size >= size)
+            std::ofstream file;
+            if (writeTracePath != "-")
             {
-                if (current->size < bestSize)
+                file.open(writeTracePath, std::ios::trunc);
+                if (!file)
                 {
-                    bestSize = current->size;
-                    bestBlock = current;
+                    std::cout << "ERROR: Cannot open trace file " << writeTracePath << "\n";
+                    return 1;
                 }
             }
-            current = current->next;
+            WriteWorkloadTrace(generator, writeTracePath == "-" ? std::cout : file);
+            return 0;
         }
 
-        return bestBlock;
-    }
-
-    // Split a block if it's larger than needed (plus minimum block size)
-    /**
-     * Block Splitting
-     *
-     * When a block is much larger than requested, splits it into two:
-     * 1. Allocated block (requested size)
-     * 2. New free block (remainder)
-     *
-     * This prevents wasting large amounts of free space in a single allocation.
-     */
-    void SplitBlock(MemoryBlock *block, size_t size)
-    {
-        if (!block)
-            return;
-
-        // Only split if the remainder would be large enough for another block
-        size_t remainingSize = block->size - size;
-        if (remainingSize < MIN_BLOCK_SIZE + HEADER_SIZE)
+        if (sweep)
         {
-            return; // Don't split if remainder is too small
+            DecodedTrace trace;
+            TraceEvent event;
+            while (generator.Next(event))
+            {
+                trace.events.push_back(event);
+            }
+            trace.slots = generator.SlotCount();
+            RunSweep(trace, sweepHeaps, sweepMinBlocks, heapConfig, threads);
+            return 0;
         }
 
-        // Create a new block at the end of the current block's data area
-        char *blockEnd = reinterpret_cast<char *>(block->GetData()) + size;
-        MemoryBlock *newBlock = reinterpret_cast<MemoryBlock *>(blockEnd);
-
-        // Set up the new block
-        newBlock->size = remainingSize - HEADER_SIZE;
-        newBlock->allocated = false;
-        newBlock->next = block->next;
-        newBlock->prev = block;
-
-        // Update the original block
-        block->size = size;
-
-        // Fix next block's prev pointer if it exists
-        if (block->next)
+        MemoryAllocator allocator(currentStrategy, heapConfig);
+        SlabAllocator slabs(allocator);
+        slabs.SetEnabled(slabEnabled);
+        ReplayStats stats = RunWorkload(generator, allocator, slabs, !allocator.IsFileBacked());
+        if (!checkpointPath.empty() && !allocator.Checkpoint(checkpointPath))
         {
-            block->next->prev = newBlock;
+            return 1;
         }
 
-        // Connect the original block to the new one
-        block->next = newBlock;
-
-        // Update statistics
-        freeBlocks++;
+        std::cout << "Strategy: " << StrategyName(allocator.GetStrategy())
+                  << (slabEnabled ? " + slab" : "") << "\n";
+        TraceReplayer::PrintReplayReport(stats);
+        return 0;
     }
 
-    // Combine adjacent free blocks to reduce fragmentation
-    /**
-     * Block Coalescing (Merging)
-     *
-     * Combines adjacent free blocks to reduce fragmentation.
-     * Prevents creation of unusable tiny free blocks.
-     *
-     * Process:
-     * 1. Merge current block with next free block (forward coalescing)
-     * 2. Merge current block with previous free block (backward coalescing)
-     */
-    void CoalesceBlocks(MemoryBlock *block)
+    // Batch mode: replay a trace and print the summary only
+    if (!replayPath.empty())
     {
-        if (!block)
-            return;
-
-        // Try to merge with the next block (if it's free)
-        if (block->next && !block->next->allocated)
+        std::ifstream file;
+        if (replayPath != "-")
         {
-            // Calculate the combined size
-            block->size += block->next->size + HEADER_SIZE;
-
-            // Update the linked list
-            MemoryBlock *nextNext = block->next->next;
-            block->next = nextNext;
-
-            if (nextNext)
+            file.open(replayPath);
+            if (!file)
             {
-                nextNext->prev = block;
+                std::cout << "ERROR: Cannot open trace file " << replayPath << "\n";
+                return 1;
             }
-
-            // Update statistics
-            freeBlocks--;
         }
 
-        // Try to merge with the previous block (if it's free)
-        if (block->prev && !block->prev->allocated)
+        if (sweep)
         {
-            // Calculate the combined size
-            block->prev->size += block->size + HEADER_SIZE;
-
-            // Update the linked list
-            block->prev->next = block->next;
-
-            if (block->next)
-            {
-                block->next->prev = block->prev;
-            }
-
-            // Update statistics
-            freeBlocks--;
+            DecodedTrace trace;
+            DecodeTrace(replayPath == "-" ? std::cin : file, trace);
+            RunSweep(trace, sweepHeaps, sweepMinBlocks, heapConfig, threads);
+            return 0;
         }
-    }
 
-    // Check if a block pointer is valid
-    /**
-     * Block Validation
-     *
-     * Verifies that a pointer points to a valid allocated block:
-     * 1. Check if address is within memory bounds
-     * 2. Traverse linked list to confirm block exists
-     */
-    bool IsValidBlock(MemoryBlock *block) const
-    {
-        if (!block)
-            return false;
+        MemoryAllocator allocator(currentStrategy, heapConfig);
+        SlabAllocator slabs(allocator);
+        slabs.SetEnabled(slabEnabled);
 
-        // Check if the block is within the memory bounds
-        char *blockAddr = reinterpret_cast<char *>(block);
-        if (blockAddr < memory || blockAddr >= memory + MEMORY_SIZE)
+        ReplayStats stats;
         {
-            return false;
-        }
-
-        // Validate block by traversing the list
-        MemoryBlock *current = firstBlock;
-        while (current)
-        {
-            if (current == block)
+            TraceReplayer replayer(allocator, slabs);
+            replayer.SetSampleInterval(timelinePath.empty() ? 0 : sampleEvery);
+            replayer.SetReleaseLive(!allocator.IsFileBacked());
+            stats = replayer.Run(replayPath == "-" ? std::cin : file);
+            if (!timelinePath.empty() && !TraceReplayer::WriteTimelineCsv(replayer.GetTimeline(), timelinePath))
             {
-                return true;
+                return 1;
             }
-            current = current->next;
-        }
-
-        return false;
-    }
-
-    // Update memory statistics
-    /**
-     * Update Statistics
-     *
-     * Recalculates memory metrics:
-     * - Largest contiguous free block
-     * - Fragmentation ratio (0.0 = perfect, 1.0 = worst)
-     */
-    void UpdateStats()
-    {
-        // Find largest free block and calculate fragmentation
-        largestFreeBlock = 0;
-        size_t freeBytesSum = 0;
-
-        MemoryBlock *current = firstBlock;
-        while (current)
-        {
-            if (!current->allocated)
+            if (!snapshotPath.empty() && !SaveHeapSnapshot(allocator, snapshotPath, SNAPSHOT_RESOLUTION))
             {
-                freeBytesSum += current->size;
-                if (current->size > largestFreeBlock)
-                {
-                    largestFreeBlock = current->size;
-                }
+                return 1;
+            }
+            if (!checkpointPath.empty() && !allocator.Checkpoint(checkpointPath))
+            {
+                return 1;
             }
-            current = current->next;
         }
+        std::cout << "Strategy: " << StrategyName(allocator.GetStrategy())
+                  << (slabEnabled ? " + slab" : "") << "\n";
+        TraceReplayer::PrintReplayReport(stats);
+        return 0;
+    }
 
-        // Calculate fragmentation as (1 - largest_free_block / total_free_memory)
-        if (totalFree > 0)
-        {
-            fragmentation = 1.0 - (static_cast<double>(largestFreeBlock) / totalFree);
-        }
-        else
-        {
-            fragmentation = 0.0;
-        }
+    // Engine mode: serve the web front-end over stdin/stdout
+    if (serve)
+    {
+        MemoryAllocator allocator(currentStrategy, heapConfig);
+        EngineServer server(allocator);
+        server.Run(std::cin, std::cout);
+        return 0;
     }
-};
 
-// Main function with user interaction
-/**
- * Main Function - Interactive Tutorial Interface
- *
- * Provides an interactive menu-driven interface where users can:
- * 1. Manually allocate and deallocate memory
- * 2. Switch between allocation strategies
- * 3. View memory statistics and visualization
- * 4. Run an automated demonstration
- *
- * This allows hands-on learning of memory management concepts.
- */
-int main()
-{
     std::cout << "Memory Allocator Simulator\n";
     std::cout << "========================\n\n";
     std::cout << "Educational Tool - Learn how Operating Systems manage memory!\n\n";
 
-    // Initialize default strategy
-    AllocationStrategy currentStrategy = AllocationStrategy::FIRST_FIT;
-
-    // Create memory allocator
-    MemoryAllocator allocator(currentStrategy);
+    // Create memory allocator, with a slab front-end for small blocks
+    // (off unless --slab is given, so allocations show up in the general heap)
+    MemoryAllocator allocator(currentStrategy, heapConfig);
+    SlabAllocator slabs(allocator);
+    slabs.SetEnabled(slabEnabled);
+    currentStrategy = allocator.GetStrategy(); // A reopened heap file keeps its own
 
     // Store allocated pointers
     std::vector<std::pair<void *, size_t>> allocatedBlocks;
@@ -609,9 +553,11 @@ int main()
         std::cout << "5. Print block details\n";
         std::cout << "6. Print memory map\n";
         std::cout << "7. Switch allocation strategy (Current: "
-                  << (currentStrategy == AllocationStrategy::FIRST_FIT ? "First Fit" : "Best Fit") << ")\n";
+                  << StrategyName(currentStrategy) << ")\n";
         std::cout << "8. Run automated demo\n";
-        std::cout << "9. Exit\n";
+        std::cout << "9. Toggle slab allocator for blocks <= " << SLAB_MAX_OBJECT
+                  << " bytes (Current: " << (slabs.IsEnabled() ? "On" : "Off") << ")\n";
+        std::cout << "10. Exit\n";
         std::cout << "Enter your choice: ";
 
         // Get user choice
@@ -638,7 +584,7 @@ int main()
                 continue;
             }
 
-            void *ptr = allocator.Allocate(size);
+            void *ptr = slabs.Allocate(size);
             if (ptr)
             {
                 allocatedBlocks.push_back({ptr, size});
@@ -685,7 +631,7 @@ int main()
             // Deallocate the selected block
             if (allocatedBlocks[blockIndex - 1].first != nullptr)
             {
-                if (allocator.Deallocate(allocatedBlocks[blockIndex - 1].first))
+                if (slabs.Deallocate(allocatedBlocks[blockIndex - 1].first))
                 {
                     std::cout << "Block #" << blockIndex << " deallocated successfully.\n";
                     allocatedBlocks[blockIndex - 1].first = nullptr; // Mark as deallocated
@@ -705,7 +651,7 @@ int main()
             {
                 if (block.first != nullptr)
                 {
-                    if (allocator.Deallocate(block.first))
+                    if (slabs.Deallocate(block.first))
                     {
                         block.first = nullptr;
                         deallocatedCount++;
@@ -718,6 +664,11 @@ int main()
 
         case 4: // Print memory report
             allocator.PrintMemoryReport();
+            allocator.PrintFreeSpaceReport();
+            if (slabs.IsEnabled() || slabs.GetStats().pages > 0)
+            {
+                slabs.PrintSlabReport();
+            }
             break;
 
         case 5: // Print block details
@@ -730,17 +681,23 @@ int main()
 
         case 7:
         { // Switch allocation strategy
-            if (currentStrategy == AllocationStrategy::FIRST_FIT)
+            int strategyChoice;
+            std::cout << "1. First Fit\n2. Best Fit\n3. Tree Best Fit\n4. Buddy\n5. Next Fit\n6. Worst Fit\n";
+            std::cout << "Select strategy: ";
+            if (!(std::cin >> strategyChoice) || strategyChoice < 1 || strategyChoice > 6)
             {
-                currentStrategy = AllocationStrategy::BEST_FIT;
-                allocator.SetStrategy(AllocationStrategy::BEST_FIT);
-                std::cout << "Switched to Best Fit allocation strategy.\n";
+                std::cin.clear();
+                std::cin.ignore(10000, '\n');
+                std::cout << "Invalid strategy.\n";
+                continue;
             }
-            else
+
+            AllocationStrategy selected = static_cast<AllocationStrategy>(strategyChoice - 1);
+            slabs.Trim(); // Empty slab pages would keep the heap from being empty
+            if (allocator.SetStrategy(selected))
             {
-                currentStrategy = AllocationStrategy::FIRST_FIT;
-                allocator.SetStrategy(AllocationStrategy::FIRST_FIT);
-                std::cout << "Switched to First Fit allocation strategy.\n";
+                currentStrategy = selected;
+                std::cout << "Switched to " << StrategyName(currentStrategy) << " allocation strategy.\n";
             }
             break;
         }
@@ -754,11 +711,12 @@ int main()
             {
                 if (block.first != nullptr)
                 {
-                    allocator.Deallocate(block.first);
+                    slabs.Deallocate(block.first);
                     block.first = nullptr;
                 }
             }
             allocatedBlocks.clear();
+            slabs.Trim();
 
             // First Fit demonstration
             std::cout << "Setting First Fit strategy...\n";
@@ -857,7 +815,12 @@ int main()
             break;
         }
 
-        case 9: // Exit
+        case 9: // Toggle slab allocator
+            slabs.SetEnabled(!slabs.IsEnabled());
+            std::cout << "Slab allocator " << (slabs.IsEnabled() ? "enabled" : "disabled") << ".\n";
+            break;
+
+        case 10: // Exit
             running = false;
             std::cout << "Exiting memory allocator simulator.\n";
             break;
@@ -868,4 +831,11 @@ int main()
     }
 
     return 0;
+}
+catch (const std::bad_alloc &)
+{
+    // The heap (or its backing file) could not be set up; the reason has
+    // been printed already when there is one
+    std::cout << "ERROR: Cannot create the heap.\n";
+    return 1;
 }
\ No newline at end of file
@@ -4,13 +4,25 @@
  * This is a Node.js Express server that wraps the C++ memory allocator
  * and provides a REST API for web-based interaction and visualization.
  * 
+ * The allocator itself runs as a long-lived engine process
+ * (`memory_allocator --serve`, see engine_server.h); every API request is
+ * one line to its stdin and one JSON line back, so the numbers shown are
+ * those of the real engine.
+ * 
+ * Build the engine first: npm run build:engine
  * Install dependencies: npm install express cors body-parser
+ * 
+ * Environment:
+ *   ALLOCATOR_ENGINE  Path to the engine binary (default ./memory_allocator)
+ *   ALLOCATOR_ARGS    Extra engine options, e.g. "--heap-size=64M --grow"
  */
 
 const express = require('express');
 const cors = require('cors');
 const bodyParser = require('body-parser');
 const path = require('path');
+const readline = require('readline');
+const { spawn } = require('child_process');
 
 const app = express();
 const PORT = process.env.PORT || 3000;
@@ -20,227 +32,135 @@ app.use(cors());
 app.use(bodyParser.json());
 app.use(express.static('public'));
 
-// In-memory simulation of the memory allocator
-// This is a JavaScript implementation that mirrors the C++ logic
-class MemoryAllocator {
-    constructor(strategy = 'FIRST_FIT') {
-        this.MEMORY_SIZE = 1024 * 1024;  // 1MB
-        this.MIN_BLOCK_SIZE = 16;
-        this.HEADER_SIZE = 16;
-        
-        this.blocks = [];
-        this.strategy = strategy;
-        this.stats = {
-            totalAllocated: 0,
-            totalFree: this.MEMORY_SIZE - this.HEADER_SIZE,
-            allocatedBlocks: 0,
-            freeBlocks: 1,
-            largestFreeBlock: this.MEMORY_SIZE - this.HEADER_SIZE,
-            fragmentation: 0.0
-        };
-        
-        // Initialize with one large free block
-        this.blocks.push({
-            id: 0,
-            address: 0,
-            size: this.MEMORY_SIZE - this.HEADER_SIZE,
-            allocated: false
+// Client for the C++ engine process
+// Commands are answered strictly in order, so pending requests form a queue
+class AllocatorEngine {
+    constructor(binary, args) {
+        this.pending = [];
+        this.process = spawn(binary, ['--serve', ...args], { stdio: ['pipe', 'pipe', 'inherit'] });
+
+        this.process.on('error', (err) => {
+            console.error(`Cannot start allocator engine ${binary}: ${err.message}`);
+            process.exit(1);
         });
-    }
-    
-    allocate(size) {
-        if (size <= 0) return null;
-        
-        if (size < this.MIN_BLOCK_SIZE) {
-            size = this.MIN_BLOCK_SIZE;
-        }
-        
-        let block = null;
-        
-        if (this.strategy === 'FIRST_FIT') {
-            block = this.findFirstFit(size);
-        } else {
-            block = this.findBestFit(size);
-        }
-        
-        if (!block) {
-            return { error: "Not enough memory" };
-        }
-        
-        // Split block if necessary
-        if (block.size > size + this.MIN_BLOCK_SIZE + this.HEADER_SIZE) {
-            const newBlockAddress = block.address + size + this.HEADER_SIZE;
-            const newBlockSize = block.size - size - this.HEADER_SIZE;
-            
-            this.blocks.push({
-                id: this.getNextBlockId(),
-                address: newBlockAddress,
-                size: newBlockSize,
-                allocated: false
-            });
-            
-            block.size = size;
-        }
-        
-        block.allocated = true;
-        this.updateStats();
-        
-        return { address: block.address, size: block.size };
-    }
-    
-    deallocate(address) {
-        const block = this.blocks.find(b => b.address === address);
-        
-        if (!block || !block.allocated) {
-            return { error: "Invalid deallocation" };
-        }
-        
-        block.allocated = false;
-        this.coalesceBlocks();
-        this.updateStats();
-        
-        return { success: true };
-    }
-    
-    findFirstFit(size) {
-        return this.blocks.find(b => !b.allocated && b.size >= size);
-    }
-    
-    findBestFit(size) {
-        let bestBlock = null;
-        let bestSize = this.MEMORY_SIZE + 1;
-        
-        for (let block of this.blocks) {
-            if (!block.allocated && block.size >= size && block.size < bestSize) {
-                bestBlock = block;
-                bestSize = block.size;
+        this.process.on('exit', (code) => {
+            console.error(`Allocator engine exited with code ${code}`);
+            process.exit(1);
+        });
+
+        readline.createInterface({ input: this.process.stdout }).on('line', (line) => {
+            const resolve = this.pending.shift();
+            if (resolve) {
+                resolve(JSON.parse(line));
             }
-        }
-        
-        return bestBlock;
+        });
     }
     
-    coalesceBlocks() {
-        // Sort blocks by address
-        this.blocks.sort((a, b) => a.address - b.address);
-        
-        for (let i = 0; i < this.blocks.length - 1; i++) {
-            const current = this.blocks[i];
-            const next = this.blocks[i + 1];
-            
-            if (!current.allocated && !next.allocated &&
-                current.address + current.size + this.HEADER_SIZE === next.address) {
-                current.size += next.size + this.HEADER_SIZE;
-                this.blocks.splice(i + 1, 1);
-                i--;
-            }
-        }
+    send(command) {
+        return new Promise((resolve) => {
+            this.pending.push(resolve);
+            this.process.stdin.write(command + '\n');
+        });
     }
     
-    updateStats() {
-        let totalAllocated = 0;
-        let totalFree = 0;
-        let allocatedBlocks = 0;
-        let freeBlocks = 0;
-        let largestFreeBlock = 0;
-        
-        for (let block of this.blocks) {
-            if (block.allocated) {
-                totalAllocated += block.size;
-                allocatedBlocks++;
-            } else {
-                totalFree += block.size;
-                freeBlocks++;
-                largestFreeBlock = Math.max(largestFreeBlock, block.size);
-            }
+    allocate(size) {
+        size = Number(size);
+        if (!Number.isSafeInteger(size) || size <= 0) {
+            return Promise.resolve({ error: 'Invalid size' });
         }
-        
-        this.stats = {
-            totalAllocated,
-            totalFree,
-            allocatedBlocks,
-            freeBlocks,
-            largestFreeBlock,
-            fragmentation: totalFree > 0 ? 1.0 - (largestFreeBlock / totalFree) : 0
-        };
+        return this.send(`a ${size}`);
     }
     
-    setStrategy(strategy) {
-        this.strategy = strategy;
+    deallocate(address) {
+        address = Number(address);
+        if (!Number.isSafeInteger(address) || address < 0) {
+            return Promise.resolve({ error: 'Invalid deallocation' });
+        }
+        return this.send(`f ${address}`);
     }
     
-    getStats() {
+    async getStats() {
+        const stats = await this.send('s');
         return {
-            ...this.stats,
-            strategy: this.strategy,
-            totalMemory: this.MEMORY_SIZE,
-            allocatedPercent: (this.stats.totalAllocated * 100 / this.MEMORY_SIZE).toFixed(2)
+            ...stats,
+            strategy: STRATEGIES[stats.strategy],
+            allocatedPercent: (stats.totalAllocated * 100 / stats.totalMemory).toFixed(2)
         };
     }
     
     getBlocks() {
-        return this.blocks.map(b => ({
-            address: b.address,
-            size: b.size,
-            allocated: b.allocated
-        }));
+        return this.send('b');
     }
     
-    getNextBlockId() {
-        return Math.max(0, ...this.blocks.map(b => b.id)) + 1;
+    setStrategy(strategy) {
+        const key = Object.keys(STRATEGIES).find(k => STRATEGIES[k] === strategy);
+        return this.send(`t ${key}`);
+    }
+    
+    reset() {
+        return this.send('r');
     }
 }
 
-// Create global allocator instance
-const allocator = new MemoryAllocator('FIRST_FIT');
+// Engine strategy keys and the names used by the API
+const STRATEGIES = {
+    first: 'FIRST_FIT',
+    best: 'BEST_FIT',
+    tree: 'TREE_BEST_FIT',
+    buddy: 'BUDDY',
+    next: 'NEXT_FIT',
+    worst: 'WORST_FIT'
+};
+
+// Start the engine
+const allocator = new AllocatorEngine(
+    process.env.ALLOCATOR_ENGINE || path.join(__dirname, 'memory_allocator'),
+    (process.env.ALLOCATOR_ARGS || '').split(/\s+/).filter(Boolean)
+);
 
 // Routes
 
 // Get current statistics
-app.get('/api/stats', (req, res) => {
-    res.json(allocator.getStats());
+app.get('/api/stats', async (req, res) => {
+    res.json(await allocator.getStats());
 });
 
 // Get all blocks
-app.get('/api/blocks', (req, res) => {
-    res.json(allocator.getBlocks());
+app.get('/api/blocks', async (req, res) => {
+    res.json(await allocator.getBlocks());
 });
 
 // Allocate memory
-app.post('/api/allocate', (req, res) => {
+app.post('/api/allocate', async (req, res) => {
     const { size } = req.body;
-    const result = allocator.allocate(size);
-    res.json(result);
+    res.json(await allocator.allocate(size));
 });
 
 // Deallocate memory
-app.post('/api/deallocate', (req, res) => {
+app.post('/api/deallocate', async (req, res) => {
     const { address } = req.body;
-    const result = allocator.deallocate(address);
-    res.json(result);
+    res.json(await allocator.deallocate(address));
 });
 
 // Set allocation strategy
-app.post('/api/strategy', (req, res) => {
+app.post('/api/strategy', async (req, res) => {
     const { strategy } = req.body;
-    if (['FIRST_FIT', 'BEST_FIT'].includes(strategy)) {
-        allocator.setStrategy(strategy);
-        res.json({ success: true, strategy });
-    } else {
+    if (!Object.values(STRATEGIES).includes(strategy)) {
         res.status(400).json({ error: 'Invalid strategy' });
+        return;
+    }
+
+    const result = await allocator.setStrategy(strategy);
+    if (result.error) {
+        res.status(409).json(result);
+    } else {
+        res.json({ success: true, strategy });
     }
 });
 
 // Reset allocator
-app.post('/api/reset', (req, res) => {
-    allocator.blocks = [{
-        id: 0,
-        address: 0,
-        size: allocator.MEMORY_SIZE - allocator.HEADER_SIZE,
-        allocated: false
-    }];
-    allocator.updateStats();
-    res.json({ success: true });
+app.post('/api/reset', async (req, res) => {
+    res.json(await allocator.reset());
 });
 
 // Start server
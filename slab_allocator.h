@@ -0,0 +1,532 @@
+/**
+ * ============================================================================
+ * SLAB ALLOCATOR - Small Object Front-End
+ * ============================================================================
+ *
+ * Serves small fixed-size objects from pages carved out of a MemoryAllocator.
+ * ============================================================================
+ */
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include "memory_allocator.h"
+
+// Slab allocator constants
+constexpr size_t SLAB_PAGE_SIZE = 4096;    // Bytes per slab page (pages are aligned to it)
+constexpr size_t SLAB_MIN_OBJECT = 16;     // Smallest slab object size
+constexpr size_t SLAB_MAX_OBJECT = 512;    // Larger requests bypass the slabs
+constexpr size_t SLAB_NUM_CLASSES = 6;     // 16, 32, 64, 128, 256, 512 bytes
+constexpr size_t SLAB_BITMAP_WORDS = SLAB_PAGE_SIZE / SLAB_MIN_OBJECT / 64;
+
+// Slab page header
+/**
+ * SlabPage Structure
+ *
+ * Sits at the start of every slab page, followed by equally sized object
+ * slots. Pages are aligned to SLAB_PAGE_SIZE, so the page of an object is
+ * its address rounded down, and the owner tag tells slab pages apart from
+ * general-heap memory. Occupancy is a bitmap (bit set = slot free), so a
+ * free slot is found with a find-first-set over at most SLAB_BITMAP_WORDS
+ * words.
+ *
+ * Members:
+ *   - next/prev: Links in the size class's list of pages with free slots
+ *   - owner: Slab allocator the page belongs to (nullptr once released)
+ *   - block: General-heap allocation the page was carved from
+ *   - objectSize: Size of every slot in this page
+ *   - capacity/used: Number of slots in the page / currently handed out
+ *   - freeMap: Occupancy bitmap
+ */
+struct alignas(ALIGNMENT) SlabPage
+{
+    SlabPage *next;                      // Next page with free slots (same class)
+    SlabPage *prev;                      // Previous page with free slots (same class)
+    const void *owner;                   // Slab allocator holding the page
+    void *block;                         // General-heap allocation holding the page
+    uint32_t objectSize;                 // Size of every slot in this page
+    uint32_t capacity;                   // Number of slots in the page
+    uint32_t used;                       // Slots currently handed out
+    uint32_t sizeClass;                  // Index of the page's size class
+    uint64_t freeMap[SLAB_BITMAP_WORDS]; // Bit set = slot free
+
+    // Start of the first object slot
+    char *GetObjects()
+    {
+        return reinterpret_cast<char *>(this) + sizeof(SlabPage);
+    }
+};
+
+// Slab statistics snapshot
+/**
+ * SlabStats Structure
+ *
+ * Utilisation of the slab layer, reported separately from the general
+ * heap (whose report sees each slab page as one allocated block).
+ *
+ * Members:
+ *   - pages: Slab pages currently held from the general heap
+ *   - slots/usedSlots: Object slots in those pages / handed out
+ *   - bytesInPages: Bytes of general heap held by slab pages
+ *   - bytesInUse: Bytes of the handed-out slots
+ *   - utilisation: usedSlots / slots (1.0 = every slot in use)
+ */
+struct SlabStats
+{
+    size_t pages;          // Slab pages held from the general heap
+    size_t slots;          // Object slots in those pages
+    size_t usedSlots;      // Slots currently handed out
+    size_t bytesInPages;   // Bytes of general heap held by slab pages
+    size_t bytesInUse;     // Bytes of the handed-out slots
+    double utilisation;    // usedSlots / slots
+};
+
+// Slab allocator front-end
+/**
+ * SlabAllocator Class
+ *
+ * Serves small requests (up to SLAB_MAX_OBJECT bytes) from fixed-size
+ * object pages carved out of a MemoryAllocator, and forwards everything
+ * else to it. Small allocations skip the general search, the split and
+ * the per-block header entirely.
+ *
+ * Key Features:
+ *   - Power-of-two size classes from 16 to 512 bytes
+ *   - O(1) allocation from the first page with a free slot
+ *   - O(1) free: an object's page is found by masking its address
+ *   - Empty pages are returned to the general heap (one spare is kept per class)
+ *   - Can be disabled, in which case every request goes to the general heap
+ */
+class SlabAllocator
+{
+private:
+    MemoryAllocator &heap; // General heap the pages come from
+    bool enabled;          // When false, every request goes straight to the heap
+
+    SlabPage *partialPages[SLAB_NUM_CLASSES]; // Pages with at least one free slot, per class
+    SlabPage *sparePages[SLAB_NUM_CLASSES];   // One empty page kept per class to avoid thrashing
+
+    // Statistics members
+    size_t classPages[SLAB_NUM_CLASSES]; // Pages held, per class
+    size_t classUsed[SLAB_NUM_CLASSES];  // Slots handed out, per class
+    size_t pageCount;      // Pages held from the general heap
+    size_t usedSlots;      // Slots currently handed out
+    size_t totalSlots;     // Slots in all pages
+    size_t bytesInUse;     // Bytes of the handed-out slots
+
+public:
+    /**
+     * Constructor - Put a slab layer in front of a general heap
+     *
+     * @param generalHeap - Allocator that provides the slab pages and
+     *                      serves requests larger than SLAB_MAX_OBJECT
+     */
+    explicit SlabAllocator(MemoryAllocator &generalHeap)
+        : heap(generalHeap), enabled(true), pageCount(0), usedSlots(0), totalSlots(0), bytesInUse(0)
+    {
+        std::fill(std::begin(partialPages), std::end(partialPages), nullptr);
+        std::fill(std::begin(sparePages), std::end(sparePages), nullptr);
+        std::fill(std::begin(classPages), std::end(classPages), 0);
+        std::fill(std::begin(classUsed), std::end(classUsed), 0);
+    }
+
+    ~SlabAllocator()
+    {
+        Trim();
+    }
+
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+    /**
+     * Enable or disable the slab layer
+     *
+     * @param on - When false, new requests all go to the general heap;
+     *             objects already in slab pages can still be freed
+     */
+    void SetEnabled(bool on)
+    {
+        enabled = on;
+    }
+
+    bool IsEnabled() const
+    {
+        return enabled;
+    }
+
+    /**
+     * Allocate memory
+     *
+     * @param size - Number of bytes to allocate
+     * @return - Pointer to allocated memory, or nullptr if allocation failed
+     *
+     * Small requests take a slot from the size class's first page with
+     * room, getting a new page from the general heap only when every
+     * page is full. Everything else goes to the general heap.
+     */
+    void *Allocate(size_t size)
+    {
+        if (!enabled || size == 0 || size > SLAB_MAX_OBJECT)
+        {
+            return heap.Allocate(size);
+        }
+
+        size_t sizeClass = SlabClass(size);
+        SlabPage *page = partialPages[sizeClass];
+        if (!page)
+        {
+            page = NewPage(sizeClass);
+            if (!page)
+            {
+                return nullptr;
+            }
+        }
+
+        // Take the first free slot in the page
+        size_t word = 0;
+        while (page->freeMap[word] == 0)
+        {
+            word++;
+        }
+        size_t bit = FloorLog2(page->freeMap[word] & (~page->freeMap[word] + 1));
+        page->freeMap[word] &= ~(1ULL << bit);
+        size_t slot = word * 64 + bit;
+
+        // A page with no free slot leaves the partial list
+        if (++page->used == page->capacity)
+        {
+            UnlinkPage(page);
+        }
+
+        // Update statistics
+        usedSlots++;
+        classUsed[sizeClass]++;
+        bytesInUse += page->objectSize;
+
+        return page->GetObjects() + slot * page->objectSize;
+    }
+
+    /**
+     * Deallocate memory
+     *
+     * @param ptr - Pointer returned by Allocate
+     * @return - True if deallocation succeeded, false otherwise
+     *
+     * Pointers inside a slab page free their slot; any other pointer is
+     * passed to the general heap. Invalid requests are reported when the
+     * general heap is verbose (see MemoryAllocator::SetVerbose).
+     */
+    bool Deallocate(void *ptr)
+    {
+        if (!ptr)
+            return false;
+
+        SlabPage *page = FindPage(ptr);
+        if (!page)
+        {
+            return heap.Deallocate(ptr);
+        }
+
+        if (!IsSlotInUse(page, ptr))
+        {
+            if (heap.IsVerbose())
+                std::cout << "ERROR: Invalid deallocation request.\n";
+            return false;
+        }
+
+        size_t slot = static_cast<size_t>(reinterpret_cast<char *>(ptr) - page->GetObjects()) / page->objectSize;
+        page->freeMap[slot / 64] |= 1ULL << (slot % 64);
+
+        // A full page becomes usable again
+        if (page->used-- == page->capacity)
+        {
+            LinkPage(page);
+        }
+
+        // Update statistics
+        usedSlots--;
+        classUsed[page->sizeClass]--;
+        bytesInUse -= page->objectSize;
+
+        if (page->used == 0)
+        {
+            RetirePage(page);
+        }
+        return true;
+    }
+
+    /**
+     * Resize memory
+     *
+     * @param ptr - Pointer returned by Allocate (nullptr = Allocate)
+     * @param size - New size in bytes (0 = Deallocate)
+     * @return - Pointer to the resized memory, or nullptr if it failed
+     *
+     * A slab object keeps its slot while the new size still belongs to the
+     * same size class; heap blocks that stay too large for the slabs are
+     * resized by the general heap (in place when it can). Everything else
+     * moves to a new object or block. A pointer that is neither a slab
+     * object nor an allocated heap block is rejected (nullptr) untouched.
+     */
+    void *Reallocate(void *ptr, size_t size)
+    {
+        if (!ptr)
+            return Allocate(size);
+
+        if (size == 0)
+        {
+            Deallocate(ptr);
+            return nullptr;
+        }
+
+        SlabPage *page = FindPage(ptr);
+        if (!page)
+        {
+            if (!enabled || size > SLAB_MAX_OBJECT)
+            {
+                return heap.Reallocate(ptr, size);
+            }
+        }
+
+        size_t oldSize = page ? (IsSlotInUse(page, ptr) ? page->objectSize : 0) : heap.GetRequestedSize(ptr);
+        if (oldSize == 0)
+        {
+            if (heap.IsVerbose())
+                std::cout << "ERROR: Invalid reallocation request.\n";
+            return nullptr;
+        }
+
+        if (page && enabled && size <= SLAB_MAX_OBJECT && SlabClass(size) == page->sizeClass)
+        {
+            return ptr;
+        }
+
+        // Move to a new object or block; the old one stays valid on failure
+        void *newPtr = Allocate(size);
+        if (!newPtr)
+        {
+            return nullptr;
+        }
+
+        std::memcpy(newPtr, ptr, std::min(oldSize, size));
+        if (!Deallocate(ptr))
+        {
+            // The heap refused the old block (e.g. it is owned by a handle)
+            Deallocate(newPtr);
+            return nullptr;
+        }
+        return newPtr;
+    }
+
+    /**
+     * Return every empty slab page to the general heap
+     *
+     * Needed before the general heap can be emptied (for example to
+     * switch to or from Buddy allocation).
+     */
+    void Trim()
+    {
+        for (size_t i = 0; i < SLAB_NUM_CLASSES; i++)
+        {
+            if (sparePages[i])
+            {
+                ReleasePage(sparePages[i]);
+                sparePages[i] = nullptr;
+            }
+        }
+    }
+
+    /**
+     * Get a snapshot of the slab statistics
+     */
+    SlabStats GetStats() const
+    {
+        SlabStats stats;
+        stats.pages = pageCount;
+        stats.slots = totalSlots;
+        stats.usedSlots = usedSlots;
+        stats.bytesInPages = pageCount * SLAB_PAGE_SIZE;
+        stats.bytesInUse = bytesInUse;
+        stats.utilisation = totalSlots > 0 ? static_cast<double>(usedSlots) / totalSlots : 0.0;
+        return stats;
+    }
+
+    /**
+     * Print slab utilisation report
+     *
+     * Shows page and slot usage per size class, separately from the
+     * general heap's fragmentation figures.
+     */
+    void PrintSlabReport() const
+    {
+        SlabStats stats = GetStats();
+
+        std::cout << "\n===== SLAB ALLOCATOR REPORT =====\n";
+        std::cout << "Slab Layer: " << (enabled ? "Enabled" : "Disabled") << "\n";
+        std::cout << "Slab Pages: " << stats.pages << " (" << stats.bytesInPages << " bytes of general heap)\n";
+        std::cout << "Slots In Use: " << stats.usedSlots << " / " << stats.slots << "\n";
+        std::cout << "Slab Utilisation: " << std::fixed << std::setprecision(2)
+                  << (stats.utilisation * 100.0) << "%\n";
+        std::cout << "Bytes In Use: " << stats.bytesInUse << "\n";
+
+        std::cout << std::left << std::setw(14) << "Object Size"
+                  << std::setw(10) << "Pages"
+                  << "Slots Used\n";
+        for (size_t i = 0; i < SLAB_NUM_CLASSES; i++)
+        {
+            std::cout << std::left << std::setw(14) << (SLAB_MIN_OBJECT << i)
+                      << std::setw(10) << classPages[i]
+                      << classUsed[i] << " / " << classPages[i] * SlabCapacity(i) << "\n";
+        }
+        std::cout << "=================================\n\n";
+    }
+
+private:
+    // Size class index for a small request (16 -> 0, ..., 512 -> 5)
+    static size_t SlabClass(size_t size)
+    {
+        if (size <= SLAB_MIN_OBJECT)
+            return 0;
+        return FloorLog2(size - 1) + 1 - FloorLog2(SLAB_MIN_OBJECT);
+    }
+
+    // Object slots in a page of a size class
+    static size_t SlabCapacity(size_t sizeClass)
+    {
+        return (SLAB_PAGE_SIZE - sizeof(SlabPage)) / (SLAB_MIN_OBJECT << sizeClass);
+    }
+
+    // Get a page for a size class (the spare if there is one) and make it partial
+    SlabPage *NewPage(size_t sizeClass)
+    {
+        SlabPage *page = sparePages[sizeClass];
+        if (page)
+        {
+            sparePages[sizeClass] = nullptr;
+            LinkPage(page);
+            return page;
+        }
+
+        // Buddy blocks cannot be aligned beyond their payload offset, but a
+        // page-sized request gets a block of twice the size, and that holds
+        // an aligned page
+        bool buddy = heap.GetStrategy() == AllocationStrategy::BUDDY;
+        void *block = buddy ? heap.Allocate(SLAB_PAGE_SIZE) : heap.AllocateAligned(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+        if (!block)
+        {
+            return nullptr;
+        }
+
+        page = reinterpret_cast<SlabPage *>(
+            (reinterpret_cast<uintptr_t>(block) + SLAB_PAGE_SIZE - 1) & ~(SLAB_PAGE_SIZE - 1));
+        page->owner = this;
+        page->block = block;
+        page->objectSize = static_cast<uint32_t>(SLAB_MIN_OBJECT << sizeClass);
+        page->capacity = static_cast<uint32_t>(SlabCapacity(sizeClass));
+        page->used = 0;
+        page->sizeClass = static_cast<uint32_t>(sizeClass);
+
+        // Mark exactly `capacity` slots free
+        for (size_t i = 0; i < SLAB_BITMAP_WORDS; i++)
+        {
+            size_t first = i * 64;
+            if (first + 64 <= page->capacity)
+                page->freeMap[i] = ~0ULL;
+            else if (first < page->capacity)
+                page->freeMap[i] = (1ULL << (page->capacity - first)) - 1;
+            else
+                page->freeMap[i] = 0;
+        }
+
+        pageCount++;
+        classPages[sizeClass]++;
+        totalSlots += page->capacity;
+        LinkPage(page);
+        return page;
+    }
+
+    // An empty page becomes the class's spare, or goes back to the heap
+    void RetirePage(SlabPage *page)
+    {
+        UnlinkPage(page);
+        if (!sparePages[page->sizeClass])
+        {
+            sparePages[page->sizeClass] = page;
+            return;
+        }
+        ReleasePage(page);
+    }
+
+    // Give an empty page back to the general heap
+    void ReleasePage(SlabPage *page)
+    {
+        totalSlots -= page->capacity;
+        pageCount--;
+        classPages[page->sizeClass]--;
+
+        // Drop the tag, or a general block reusing the memory would look
+        // like a slab page
+        page->owner = nullptr;
+        heap.Deallocate(page->block);
+    }
+
+    // Whether a pointer is the start of a slot of the page that is in use
+    static bool IsSlotInUse(SlabPage *page, void *ptr)
+    {
+        if (reinterpret_cast<char *>(ptr) < page->GetObjects())
+            return false;
+
+        size_t offset = static_cast<size_t>(reinterpret_cast<char *>(ptr) - page->GetObjects());
+        size_t slot = offset / page->objectSize;
+        return offset % page->objectSize == 0 && slot < page->capacity &&
+               !(page->freeMap[slot / 64] & (1ULL << (slot % 64)));
+    }
+
+    // Find the slab page containing ptr, or nullptr for general-heap pointers
+    SlabPage *FindPage(void *ptr) const
+    {
+        // The page of a slab object is its address rounded down; objects
+        // never start a page, and memory outside the heap is not read
+        uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        SlabPage *page = reinterpret_cast<SlabPage *>(address & ~(SLAB_PAGE_SIZE - 1));
+        if (reinterpret_cast<uintptr_t>(page) == address || !heap.Contains(page))
+        {
+            return nullptr;
+        }
+        return page->owner == this ? page : nullptr;
+    }
+
+    // Push a page onto its class's partial list
+    void LinkPage(SlabPage *page)
+    {
+        SlabPage *&head = partialPages[page->sizeClass];
+        page->prev = nullptr;
+        page->next = head;
+        if (head)
+        {
+            head->prev = page;
+        }
+        head = page;
+    }
+
+    // Remove a page from its class's partial list
+    void UnlinkPage(SlabPage *page)
+    {
+        if (page->prev)
+        {
+            page->prev->next = page->next;
+        }
+        else
+        {
+            partialPages[page->sizeClass] = page->next;
+        }
+        if (page->next)
+        {
+            page->next->prev = page->prev;
+        }
+        page->next = nullptr;
+        page->prev = nullptr;
+    }
+};
+
+#endif // SLAB_ALLOCATOR_H
@@ -0,0 +1,467 @@
+/**
+ * ============================================================================
+ * TRACE REPLAY - Batch Driver for the Allocator
+ * ============================================================================
+ *
+ * Streams an allocation trace through a heap without any per-operation
+ * output, and summarises throughput and fragmentation at the end.
+ *
+ * Trace format (one event per line, '#' starts a comment):
+ *   a <id> <size>   Allocate <size> bytes under handle <id>
+ *   f <id>          Free the block of handle <id>
+ *   r <id> <size>   Resize the block of handle <id> to <size> bytes
+ * ============================================================================
+ */
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "memory_allocator.h"
+#include "slab_allocator.h"
+
+#include <chrono>
+#include <fstream>
+#include <istream>
+#include <unordered_map>
+
+// Request sizes whose unusable free bytes every timeline sample records
+constexpr size_t TIMELINE_PROBES[] = {64, 256, 1024, 4096, 16384, 65536};
+constexpr size_t NUM_TIMELINE_PROBES = sizeof(TIMELINE_PROBES) / sizeof(TIMELINE_PROBES[0]);
+
+// Parse an unsigned decimal trace field, advancing the cursor past it;
+// fails when the value overflows or text runs on from the digits ("12x")
+inline bool ParseTraceField(const char *&cursor, uint64_t &value)
+{
+    while (*cursor == ' ' || *cursor == '\t')
+    {
+        cursor++;
+    }
+    if (*cursor < '0' || *cursor > '9')
+    {
+        return false;
+    }
+
+    value = 0;
+    while (*cursor >= '0' && *cursor <= '9')
+    {
+        uint64_t digit = static_cast<uint64_t>(*cursor - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+        cursor++;
+    }
+    return *cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\0';
+}
+
+// Whether nothing but blanks is left on a trace line
+inline bool AtTraceLineEnd(const char *cursor)
+{
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+    {
+        cursor++;
+    }
+    return *cursor == '\0';
+}
+
+// Parse one event line (leading blanks already skipped); false if it is
+// malformed
+inline bool ParseTraceEvent(const char *cursor, char &op, uint64_t &id, uint64_t &size)
+{
+    op = *cursor++;
+    size = 0;
+    return (op == 'a' || op == 'f' || op == 'r') && ParseTraceField(cursor, id) &&
+           (op == 'f' || ParseTraceField(cursor, size)) && AtTraceLineEnd(cursor);
+}
+
+// Replay results
+/**
+ * ReplayStats Structure
+ *
+ * Members:
+ *   - events: Trace events processed (comments and blank lines excluded)
+ *   - allocs/frees/reallocs: Events of each kind
+ *   - failedAllocs: Allocations and resizes the heap could not satisfy
+ *   - reallocsInPlace: Resizes the general heap did without moving the block
+ *   - invalidEvents: Malformed lines and unknown or reused handle ids
+ *   - liveHandles: Handles still allocated when the trace ended
+ *   - peakAllocated: Highest number of bytes allocated at once
+ *   - finalFragmentation/peakFragmentation: External fragmentation at the
+ *     end of the trace / highest value seen after any event
+ *   - seconds: Wall time of the replay, parsing included
+ */
+struct ReplayStats
+{
+    size_t events = 0;
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t reallocs = 0;
+    size_t failedAllocs = 0;
+    size_t reallocsInPlace = 0;
+    size_t invalidEvents = 0;
+    size_t liveHandles = 0;
+    size_t peakAllocated = 0;
+    double finalFragmentation = 0.0;
+    double peakFragmentation = 0.0;
+    double seconds = 0.0;
+};
+
+// One decoded trace event
+/**
+ * TraceEvent Structure
+ *
+ * Slots are dense handle ids (renumbered when a trace is decoded, handed
+ * out densely by the workload generator), so a replay keeps its live
+ * blocks in a plain array instead of a hash map.
+ *
+ * Members:
+ *   - op: 'a', 'f' or 'r' (0 for a malformed line)
+ *   - slot: Dense index of the event's handle id
+ *   - size: Requested size ('a' and 'r')
+ */
+struct TraceEvent
+{
+    uint64_t size;
+    uint32_t slot;
+    char op;
+};
+
+/**
+ * Apply one decoded event
+ *
+ * @param event - Event to apply (op 0 counts as invalid)
+ * @param front - Heap or front-end serving the event (anything with
+ *                Allocate, Deallocate and Reallocate)
+ * @param live - Live blocks by slot (sized to cover every slot)
+ * @param stats - Receives the event counts
+ */
+template <typename Front>
+void ApplyTraceEvent(const TraceEvent &event, Front &front, std::vector<void *> &live, ReplayStats &stats)
+{
+    stats.events++;
+    if (event.op != 'a' && event.op != 'f' && event.op != 'r')
+    {
+        // A malformed line has no slot of its own (a trace may have none)
+        stats.invalidEvents++;
+        return;
+    }
+    void *&ptr = live[event.slot];
+
+    switch (event.op)
+    {
+    case 'a':
+        stats.allocs++;
+        if (ptr)
+        {
+            stats.invalidEvents++;
+        }
+        else if (!(ptr = front.Allocate(event.size)))
+        {
+            stats.failedAllocs++;
+        }
+        break;
+
+    case 'f':
+        stats.frees++;
+        if (!ptr)
+        {
+            stats.invalidEvents++;
+        }
+        else
+        {
+            front.Deallocate(ptr);
+            ptr = nullptr;
+        }
+        break;
+
+    case 'r':
+        stats.reallocs++;
+        if (!ptr || event.size == 0)
+        {
+            stats.invalidEvents++;
+        }
+        else if (void *resized = front.Reallocate(ptr, event.size))
+        {
+            ptr = resized;
+        }
+        else
+        {
+            stats.failedAllocs++;
+        }
+        break;
+    }
+}
+
+// Fragmentation timeline sample
+/**
+ * FragmentationSample Structure
+ *
+ * The state of the general heap after one trace event.
+ *
+ * Members:
+ *   - event: Number of events replayed so far
+ *   - totalAllocated/totalFree/freeBlocks/largestFreeBlock/fragmentation:
+ *     Heap statistics at that point
+ *   - unusable: Free bytes too small for a request of each TIMELINE_PROBES size
+ */
+struct FragmentationSample
+{
+    size_t event;
+    size_t totalAllocated;
+    size_t totalFree;
+    size_t freeBlocks;
+    size_t largestFreeBlock;
+    double fragmentation;
+    size_t unusable[NUM_TIMELINE_PROBES];
+};
+
+// Batch trace driver
+/**
+ * TraceReplayer Class
+ *
+ * Reads a trace one line at a time and applies each event with
+ * ApplyTraceEvent, like a sweep run. Handle ids map to dense slots that
+ * are recycled once their block is gone, so memory use depends on the
+ * number of live handles rather than on the length of the trace.
+ * Requests go through a SlabAllocator, which simply forwards them to the
+ * general heap while it is disabled.
+ */
+class TraceReplayer
+{
+private:
+    MemoryAllocator &heap;                          // Heap whose statistics are tracked
+    SlabAllocator &front;                           // Entry point for every request
+    std::unordered_map<uint64_t, uint32_t> slotOf;  // Slot of each live handle id
+    std::vector<void *> live;                       // Live blocks by slot
+    std::vector<uint32_t> freeSlots;                // Slots to reuse for new ids
+    ReplayStats stats;
+    size_t sampleInterval = 0;                      // Events between timeline samples (0 = off)
+    std::vector<FragmentationSample> timeline;      // Sampled fragmentation history
+    bool releaseLive = true;                        // Free the live handles on destruction
+
+public:
+    TraceReplayer(MemoryAllocator &generalHeap, SlabAllocator &slabs)
+        : heap(generalHeap), front(slabs)
+    {
+    }
+
+    ~TraceReplayer()
+    {
+        if (!releaseLive)
+            return;
+
+        for (void *ptr : live)
+        {
+            if (ptr)
+            {
+                front.Deallocate(ptr);
+            }
+        }
+    }
+
+    TraceReplayer(const TraceReplayer &) = delete;
+    TraceReplayer &operator=(const TraceReplayer &) = delete;
+
+    /**
+     * Record a fragmentation timeline while replaying
+     *
+     * @param events - Take a sample every this many events (0 = no
+     *                 timeline); the end of the trace is always sampled
+     */
+    void SetSampleInterval(size_t events)
+    {
+        sampleInterval = events;
+    }
+
+    /**
+     * Choose whether handles still live at the end are freed
+     *
+     * @param release - False leaves their blocks allocated, for a heap that
+     *                  outlives the replay (a heap file)
+     */
+    void SetReleaseLive(bool release)
+    {
+        releaseLive = release;
+    }
+
+    /**
+     * Samples recorded by Run (empty unless SetSampleInterval was called)
+     */
+    const std::vector<FragmentationSample> &GetTimeline() const
+    {
+        return timeline;
+    }
+
+    /**
+     * Replay a whole trace
+     *
+     * @param in - Trace stream (file or stdin)
+     * @return - Statistics of the run; handles left open stay allocated
+     *           until the replayer is destroyed
+     */
+    ReplayStats Run(std::istream &in)
+    {
+        heap.SetVerbose(false);
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const char *cursor = line.c_str();
+            while (*cursor == ' ' || *cursor == '\t')
+            {
+                cursor++;
+            }
+            if (*cursor == '\0' || *cursor == '#' || *cursor == '\r')
+            {
+                continue;
+            }
+
+            Apply(cursor);
+
+            MemoryStats heapStats = heap.GetStats();
+            stats.peakAllocated = std::max(stats.peakAllocated, heapStats.totalAllocated);
+            stats.peakFragmentation = std::max(stats.peakFragmentation, heapStats.fragmentation);
+
+            if (sampleInterval > 0 && stats.events % sampleInterval == 0)
+            {
+                Sample(heapStats);
+            }
+        }
+
+        if (sampleInterval > 0 && (timeline.empty() || timeline.back().event != stats.events))
+        {
+            Sample(heap.GetStats());
+        }
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.finalFragmentation = heap.GetStats().fragmentation;
+        stats.reallocsInPlace = heap.GetStats().reallocsInPlace;
+        stats.liveHandles = slotOf.size();
+        return stats;
+    }
+
+    /**
+     * Print the summary of a replay
+     */
+    static void PrintReplayReport(const ReplayStats &stats)
+    {
+        std::cout << "\n=== Trace Replay Report ===\n";
+        std::cout << "Events: " << stats.events << " (" << stats.allocs << " alloc, "
+                  << stats.frees << " free, " << stats.reallocs << " realloc)\n";
+        std::cout << "Elapsed: " << std::fixed << std::setprecision(3) << stats.seconds << " s\n";
+        std::cout << "Throughput: " << std::setprecision(0)
+                  << (stats.seconds > 0 ? stats.events / stats.seconds : 0.0) << " events/s\n";
+        std::cout << "Failed Allocations: " << stats.failedAllocs << "\n";
+        if (stats.reallocs > 0)
+        {
+            std::cout << "Reallocs In Place: " << stats.reallocsInPlace << " of " << stats.reallocs << "\n";
+        }
+        std::cout << "Invalid Events: " << stats.invalidEvents << "\n";
+        std::cout << "Live Handles at End: " << stats.liveHandles << "\n";
+        std::cout << "Peak Allocated: " << stats.peakAllocated << " bytes\n";
+        std::cout << "Final Fragmentation: " << std::setprecision(2)
+                  << (stats.finalFragmentation * 100) << "%\n";
+        std::cout << "Peak Fragmentation: " << (stats.peakFragmentation * 100) << "%\n";
+        std::cout << "===========================\n";
+    }
+
+    /**
+     * Write a timeline as CSV
+     *
+     * @param timeline - Samples from GetTimeline
+     * @param path - Output file (overwritten)
+     * @return - True if the file was written
+     *
+     * One row per sample; the unusable_<size> columns hold the free bytes
+     * too small for a request of that size.
+     */
+    static bool WriteTimelineCsv(const std::vector<FragmentationSample> &timeline, const std::string &path)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR: Cannot open timeline file " << path << "\n";
+            return false;
+        }
+
+        file << "event,allocated,free,free_blocks,largest_free,fragmentation";
+        for (size_t probe : TIMELINE_PROBES)
+        {
+            file << ",unusable_" << probe;
+        }
+        file << "\n";
+
+        for (const FragmentationSample &sample : timeline)
+        {
+            file << sample.event << "," << sample.totalAllocated << "," << sample.totalFree << ","
+                 << sample.freeBlocks << "," << sample.largestFreeBlock << ","
+                 << std::fixed << std::setprecision(4) << sample.fragmentation;
+            for (size_t unusable : sample.unusable)
+            {
+                file << "," << unusable;
+            }
+            file << "\n";
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    // Record the heap's current state in the timeline
+    void Sample(const MemoryStats &heapStats)
+    {
+        FragmentationSample sample;
+        sample.event = stats.events;
+        sample.totalAllocated = heapStats.totalAllocated;
+        sample.totalFree = heapStats.totalFree;
+        sample.freeBlocks = heapStats.freeBlocks;
+        sample.largestFreeBlock = heapStats.largestFreeBlock;
+        sample.fragmentation = heapStats.fragmentation;
+        for (size_t i = 0; i < NUM_TIMELINE_PROBES; i++)
+        {
+            sample.unusable[i] = heap.UnusableBytes(TIMELINE_PROBES[i]);
+        }
+        timeline.push_back(sample);
+    }
+
+    // Apply one event line through the shared event logic
+    void Apply(const char *cursor)
+    {
+        TraceEvent event = {0, 0, 0};
+        uint64_t id = 0;
+        char op = 0;
+        if (!ParseTraceEvent(cursor, op, id, event.size))
+        {
+            ApplyTraceEvent(event, front, live, stats);
+            return;
+        }
+
+        auto found = slotOf.find(id);
+        if (found == slotOf.end())
+        {
+            if (freeSlots.empty())
+            {
+                freeSlots.push_back(static_cast<uint32_t>(live.size()));
+                live.push_back(nullptr);
+            }
+            found = slotOf.emplace(id, freeSlots.back()).first;
+            freeSlots.pop_back();
+        }
+
+        event.op = op;
+        event.slot = found->second;
+        ApplyTraceEvent(event, front, live, stats);
+
+        // A handle without a block (freed, failed or never valid) gives its
+        // slot back
+        if (!live[event.slot])
+        {
+            freeSlots.push_back(event.slot);
+            slotOf.erase(found);
+        }
+    }
+};
+
+#endif // TRACE_REPLAY_H
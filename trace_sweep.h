@@ -0,0 +1,291 @@
+/**
+ * ============================================================================
+ * TRACE SWEEP - Parallel Configuration Comparison
+ * ============================================================================
+ *
+ * Replays one trace against many allocator configurations (strategy, heap
+ * size, minimum block size) to find the best fit for a workload. The trace
+ * is decoded once into a compact read-only event array that every run
+ * shares; each run owns a private allocator, so the runs share no mutable
+ * state and are spread over a pool of worker threads.
+ * ============================================================================
+ */
+
+#ifndef TRACE_SWEEP_H
+#define TRACE_SWEEP_H
+
+#include "trace_replay.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Minimum block sizes a sweep can use (each one is a separate instantiation)
+constexpr size_t SWEEP_MIN_BLOCKS[] = {16, 32, 64, 128, 256};
+
+// A trace decoded into memory
+/**
+ * DecodedTrace Structure
+ *
+ * Members:
+ *   - events: Every event in trace order
+ *   - slots: Number of distinct handle ids
+ */
+struct DecodedTrace
+{
+    std::vector<TraceEvent> events;
+    size_t slots = 0;
+};
+
+/**
+ * Decode a trace (same format as TraceReplayer)
+ *
+ * @param in - Trace stream
+ * @param trace - Receives the events
+ */
+inline void DecodeTrace(std::istream &in, DecodedTrace &trace)
+{
+    std::unordered_map<uint64_t, uint32_t> slotOf;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const char *cursor = line.c_str();
+        while (*cursor == ' ' || *cursor == '\t')
+        {
+            cursor++;
+        }
+        if (*cursor == '\0' || *cursor == '#' || *cursor == '\r')
+        {
+            continue;
+        }
+
+        TraceEvent event = {0, 0, 0};
+        char op = 0;
+        uint64_t id = 0;
+        if (ParseTraceEvent(cursor, op, id, event.size))
+        {
+            event.op = op;
+            event.slot = slotOf.emplace(id, static_cast<uint32_t>(slotOf.size())).first->second;
+        }
+        trace.events.push_back(event);
+    }
+    trace.slots = slotOf.size();
+}
+
+// One sweep configuration and its outcome
+/**
+ * SweepResult Structure
+ *
+ * Members:
+ *   - strategy/heapSize/minBlock: The configuration (heapSize becomes the
+ *                                 initial size the heap was created with,
+ *                                 once the default and page rounding apply)
+ *   - stats: Replay statistics (as TraceReplayer reports them; the slab
+ *            layer is not used)
+ *   - finalHeapSize: Heap size at the end (differs when the heap grew)
+ *   - failed: The heap could not be created, so nothing was replayed
+ */
+struct SweepResult
+{
+    AllocationStrategy strategy;
+    size_t heapSize;
+    size_t minBlock;
+    ReplayStats stats;
+    size_t finalHeapSize;
+    bool failed;
+};
+
+// Allocator with a runtime strategy and a chosen minimum block size
+template <size_t MinBlock>
+class SweepAllocator : public BasicMemoryAllocator<RuntimeFitPolicy, MEMORY_SIZE, MinBlock>
+{
+public:
+    SweepAllocator(AllocationStrategy strat, const HeapConfig &heapConfig)
+        : BasicMemoryAllocator<RuntimeFitPolicy, MEMORY_SIZE, MinBlock>(strat, heapConfig)
+    {
+    }
+};
+
+// Parallel sweep driver
+/**
+ * TraceSweeper Class
+ *
+ * Holds the decoded trace and runs every configuration of the grid
+ * strategies x heap sizes x minimum block sizes. Workers take the next
+ * configuration from an atomic counter, so long and short runs balance
+ * out on their own.
+ */
+class TraceSweeper
+{
+private:
+    const DecodedTrace &trace; // Shared, read-only during the sweep
+
+public:
+    explicit TraceSweeper(const DecodedTrace &decoded)
+        : trace(decoded)
+    {
+    }
+
+    /**
+     * Run the whole grid
+     *
+     * @param strategies/heapSizes/minBlocks - Values of each dimension
+     *                                         (minBlocks from SWEEP_MIN_BLOCKS)
+     * @param baseConfig - Growth settings shared by every run (the runs
+     *                      never use its backing file)
+     * @param threads - Worker threads (0 = one per hardware thread)
+     * @return - One result per configuration, in grid order
+     */
+    std::vector<SweepResult> Run(const std::vector<AllocationStrategy> &strategies,
+                                 const std::vector<size_t> &heapSizes,
+                                 const std::vector<size_t> &minBlocks,
+                                 const HeapConfig &baseConfig, size_t threads = 0)
+    {
+        std::vector<SweepResult> results;
+        for (size_t minBlock : minBlocks)
+        {
+            for (size_t heapSize : heapSizes)
+            {
+                for (AllocationStrategy strategy : strategies)
+                {
+                    results.push_back(SweepResult{strategy, heapSize, minBlock, ReplayStats(), 0, false});
+                }
+            }
+        }
+
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, results.size());
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < results.size(); i = next++)
+            {
+                HeapConfig config = baseConfig;
+                config.heapSize = results[i].heapSize;
+                config.backingFile.clear();
+                RunConfig(results[i], config);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i++)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : workers)
+        {
+            thread.join();
+        }
+        return results;
+    }
+
+    /**
+     * Print the results as a comparison table
+     */
+    static void PrintSweepReport(const std::vector<SweepResult> &results)
+    {
+        std::cout << "\n=== Trace Sweep Report ===\n";
+        std::cout << std::left << std::setw(15) << "Strategy"
+                  << std::right << std::setw(12) << "Heap"
+                  << std::setw(10) << "MinBlock"
+                  << std::setw(14) << "Events/s"
+                  << std::setw(10) << "Failed"
+                  << std::setw(12) << "Peak Frag"
+                  << std::setw(12) << "Final Frag"
+                  << std::setw(14) << "Final Heap" << "\n";
+        std::cout << std::string(99, '-') << "\n";
+
+        for (const SweepResult &result : results)
+        {
+            const ReplayStats &stats = result.stats;
+            std::cout << std::left << std::setw(15) << StrategyName(result.strategy)
+                      << std::right << std::setw(12) << result.heapSize
+                      << std::setw(10) << result.minBlock;
+            if (result.failed)
+            {
+                std::cout << "  Cannot create the heap.\n";
+                continue;
+            }
+            std::cout << std::setw(14) << std::fixed << std::setprecision(0)
+                      << (stats.seconds > 0 ? stats.events / stats.seconds : 0.0)
+                      << std::setw(10) << stats.failedAllocs
+                      << std::setw(11) << std::setprecision(2) << stats.peakFragmentation * 100 << "%"
+                      << std::setw(11) << stats.finalFragmentation * 100 << "%"
+                      << std::setw(14) << result.finalHeapSize << "\n";
+        }
+        std::cout << "==========================\n";
+    }
+
+private:
+    // Run one configuration on its own allocator
+    void RunConfig(SweepResult &result, const HeapConfig &config)
+    {
+        switch (result.minBlock)
+        {
+        case 16:
+            Replay<SweepAllocator<16>>(result, config);
+            break;
+        case 32:
+            Replay<SweepAllocator<32>>(result, config);
+            break;
+        case 64:
+            Replay<SweepAllocator<64>>(result, config);
+            break;
+        case 128:
+            Replay<SweepAllocator<128>>(result, config);
+            break;
+        case 256:
+            Replay<SweepAllocator<256>>(result, config);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Replay the decoded trace through one allocator (a heap that cannot be
+    // created marks the run failed instead of leaving the worker thread)
+    template <typename Heap>
+    void Replay(SweepResult &result, const HeapConfig &config)
+    {
+        std::unique_ptr<Heap> created;
+        try
+        {
+            created = std::make_unique<Heap>(result.strategy, config);
+        }
+        catch (const std::bad_alloc &)
+        {
+            result.failed = true;
+            return;
+        }
+        Heap &heap = *created;
+        heap.SetVerbose(false);
+        result.heapSize = heap.GetStats().totalMemory;
+
+        ReplayStats &stats = result.stats;
+        std::vector<void *> live(trace.slots, nullptr);
+        auto start = std::chrono::steady_clock::now();
+
+        for (const TraceEvent &event : trace.events)
+        {
+            ApplyTraceEvent(event, heap, live, stats);
+
+            MemoryStats heapStats = heap.GetStats();
+            stats.peakAllocated = std::max(stats.peakAllocated, heapStats.totalAllocated);
+            stats.peakFragmentation = std::max(stats.peakFragmentation, heapStats.fragmentation);
+        }
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        MemoryStats heapStats = heap.GetStats();
+        stats.finalFragmentation = heapStats.fragmentation;
+        stats.reallocsInPlace = heapStats.reallocsInPlace;
+        stats.liveHandles = static_cast<size_t>(std::count_if(live.begin(), live.end(), [](void *p) { return p != nullptr; }));
+        result.finalHeapSize = heapStats.totalMemory;
+    }
+};
+
+#endif // TRACE_SWEEP_H
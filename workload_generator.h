@@ -0,0 +1,651 @@
+/**
+ * ============================================================================
+ * WORKLOAD GENERATOR - Deterministic Synthetic Allocation Streams
+ * ============================================================================
+ *
+ * Produces realistic allocation traces without production data. A workload
+ * is a list of phases, each with its own size distribution and lifetime
+ * model; events are generated one at a time from a fixed seed, so the same
+ * seed always gives the same stream and no schedule is ever held in memory.
+ *
+ * Size distributions:
+ *   uniform     Every size in [min, max] equally likely
+ *   zipf        Sizes min, min + ALIGNMENT, ... ranked by popularity,
+ *               P(rank k) ~ 1 / k^shape (shape default 1.1)
+ *   lognormal   Median sqrt(min * max), sigma = shape (default 1.0),
+ *               clamped to [min, max]
+ *   bimodal     Small [min, 4 * min] blocks, with a share of shape
+ *               (default 0.1) large [max / 4, max] ones
+ *
+ * Lifetime models:
+ *   lifo        Stack churn around `live` blocks: the newest block dies first
+ *   fifo        Queue churn around `live` blocks: the oldest block dies first
+ *   exponential Every block lives an exponential number of events
+ *               (mean `mean`)
+ *   outliers    As exponential, but a share `outliers` of the blocks lives
+ *               OUTLIER_LIFETIME_FACTOR times longer
+ *
+ * Events use dense slot numbers that are recycled as blocks die, so a
+ * consumer tracks live blocks in an array as large as the peak live set.
+ * ============================================================================
+ */
+
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include "trace_replay.h"
+
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <ostream>
+
+constexpr double OUTLIER_LIFETIME_FACTOR = 100.0; // Lifetime multiplier of an outlier block
+
+// Size distribution of a phase
+enum class SizeDistribution
+{
+    UNIFORM,    // Every size equally likely
+    ZIPF,       // Small sizes far more popular than large ones
+    LOG_NORMAL, // Bell curve on a log scale with a long tail
+    BIMODAL     // Mostly small blocks, some large ones
+};
+
+// Lifetime model of a phase
+enum class LifetimeModel
+{
+    LIFO,        // Newest block freed first
+    FIFO,        // Oldest block freed first
+    EXPONENTIAL, // Random exponential lifetimes
+    OUTLIERS     // Exponential lifetimes with some long-lived blocks
+};
+
+// Short command-line name of a size distribution
+inline const char *SizeDistributionKey(SizeDistribution sizes)
+{
+    switch (sizes)
+    {
+    case SizeDistribution::UNIFORM:
+        return "uniform";
+    case SizeDistribution::ZIPF:
+        return "zipf";
+    case SizeDistribution::LOG_NORMAL:
+        return "lognormal";
+    case SizeDistribution::BIMODAL:
+        return "bimodal";
+    }
+    return "unknown";
+}
+
+// Short command-line name of a lifetime model
+inline const char *LifetimeModelKey(LifetimeModel lifetime)
+{
+    switch (lifetime)
+    {
+    case LifetimeModel::LIFO:
+        return "lifo";
+    case LifetimeModel::FIFO:
+        return "fifo";
+    case LifetimeModel::EXPONENTIAL:
+        return "exponential";
+    case LifetimeModel::OUTLIERS:
+        return "outliers";
+    }
+    return "unknown";
+}
+
+// Parse a size distribution name such as "zipf"
+inline bool ParseSizeDistribution(const std::string &text, SizeDistribution &sizes)
+{
+    for (SizeDistribution candidate : {SizeDistribution::UNIFORM, SizeDistribution::ZIPF,
+                                       SizeDistribution::LOG_NORMAL, SizeDistribution::BIMODAL})
+    {
+        if (text == SizeDistributionKey(candidate))
+        {
+            sizes = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parse a lifetime model name such as "fifo"
+inline bool ParseLifetimeModel(const std::string &text, LifetimeModel &lifetime)
+{
+    for (LifetimeModel candidate : {LifetimeModel::LIFO, LifetimeModel::FIFO,
+                                    LifetimeModel::EXPONENTIAL, LifetimeModel::OUTLIERS})
+    {
+        if (text == LifetimeModelKey(candidate))
+        {
+            lifetime = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One phase of a workload
+/**
+ * WorkloadPhase Structure
+ *
+ * Members:
+ *   - events: Allocate/free events the phase produces
+ *   - sizes/minSize/maxSize: Size distribution and its range
+ *   - shape: Distribution parameter (0 = the distribution's default)
+ *   - lifetime: Lifetime model
+ *   - liveTarget: Live blocks the lifo/fifo churn hovers around
+ *   - meanLifetime: Mean lifetime in events (exponential/outliers)
+ *   - outlierRate: Share of long-lived blocks (outliers)
+ */
+struct WorkloadPhase
+{
+    uint64_t events = 1000000;
+    SizeDistribution sizes = SizeDistribution::UNIFORM;
+    size_t minSize = 16;
+    size_t maxSize = 1024;
+    double shape = 0.0;
+    LifetimeModel lifetime = LifetimeModel::EXPONENTIAL;
+    size_t liveTarget = 1000;
+    double meanLifetime = 1000.0;
+    double outlierRate = 0.01;
+};
+
+// Seeded PRNG of the generator (xorshift64*), identical on every platform
+struct WorkloadRng
+{
+    uint64_t state;
+
+    explicit WorkloadRng(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    uint64_t Next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform integer in [low, high]
+    uint64_t Range(uint64_t low, uint64_t high)
+    {
+        return low + Next() % (high - low + 1);
+    }
+
+    // Uniform double in (0, 1]
+    double Unit()
+    {
+        return ((Next() >> 11) + 1) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// Zipf sampler
+/**
+ * ZipfSampler Class
+ *
+ * Draws ranks 1..n with P(k) ~ 1 / k^exponent in constant time by
+ * rejection-inversion (Hoermann and Derflinger), so no table of n
+ * probabilities is built.
+ */
+class ZipfSampler
+{
+private:
+    uint64_t n = 1;
+    double exponent = 1.0;
+    double hIntegralX1 = 0.0;
+    double hIntegralN = 0.0;
+    double squeeze = 0.0;
+
+    // (exp(x) - 1) / x, accurate near 0
+    static double Helper2(double x)
+    {
+        return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x / 2.0 * (1.0 + x / 3.0 * (1.0 + x / 4.0));
+    }
+
+    // log(1 + x) / x, accurate near 0
+    static double Helper1(double x)
+    {
+        return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    double H(double x) const
+    {
+        return std::exp(-exponent * std::log(x));
+    }
+
+    double HIntegral(double x) const
+    {
+        double logX = std::log(x);
+        return Helper2((1.0 - exponent) * logX) * logX;
+    }
+
+    double HIntegralInverse(double x) const
+    {
+        double t = std::max(x * (1.0 - exponent), -1.0);
+        return std::exp(Helper1(t) * x);
+    }
+
+public:
+    void Reset(uint64_t count, double zipfExponent)
+    {
+        n = std::max<uint64_t>(count, 1);
+        exponent = zipfExponent;
+        hIntegralX1 = HIntegral(1.5) - 1.0;
+        hIntegralN = HIntegral(static_cast<double>(n) + 0.5);
+        squeeze = 2.0 - HIntegralInverse(HIntegral(2.5) - H(2.0));
+    }
+
+    // Rank in [1, n]
+    uint64_t Sample(WorkloadRng &rng) const
+    {
+        while (true)
+        {
+            double u = hIntegralN + rng.Unit() * (hIntegralX1 - hIntegralN);
+            double x = HIntegralInverse(u);
+            uint64_t k = static_cast<uint64_t>(std::min(std::max(x + 0.5, 1.0), static_cast<double>(n)));
+            if (k - x <= squeeze || u >= HIntegral(k + 0.5) - H(static_cast<double>(k)))
+            {
+                return k;
+            }
+        }
+    }
+};
+
+// Streaming workload generator
+/**
+ * WorkloadGenerator Class
+ *
+ * Produces TraceEvents ('a' and 'f' only) phase after phase. The live set
+ * carries over from one phase to the next and is handed to the new
+ * lifetime model; with drain set, the live blocks are freed once the last
+ * phase ends. Memory use is proportional to the live set, not to the
+ * number of events.
+ */
+class WorkloadGenerator
+{
+private:
+    typedef std::pair<uint64_t, uint32_t> Death; // (event of death, slot)
+
+    std::vector<WorkloadPhase> phases;
+    uint64_t seed;
+    bool drain;
+
+    WorkloadRng rng;
+    ZipfSampler zipf;
+    size_t phaseIndex = 0;
+    uint64_t phaseEvents = 0;  // Events produced in the current phase
+    uint64_t now = 0;          // Events produced in total
+
+    std::vector<uint32_t> freeSlots; // Recycled slot numbers
+    uint32_t slotCount = 0;          // Slots handed out so far
+    std::deque<uint32_t> order;      // Live slots, oldest first (lifo/fifo)
+    std::vector<Death> deaths;       // Min-heap of live slots by death (exponential/outliers)
+
+public:
+    /**
+     * Constructor
+     *
+     * @param workloadPhases - Phases in order (at least one)
+     * @param workloadSeed - Seed; the same seed gives the same events
+     * @param drainAtEnd - Free every live block after the last phase
+     */
+    WorkloadGenerator(const std::vector<WorkloadPhase> &workloadPhases, uint64_t workloadSeed, bool drainAtEnd = false)
+        : phases(workloadPhases), seed(workloadSeed), drain(drainAtEnd), rng(workloadSeed)
+    {
+        Reset();
+    }
+
+    /**
+     * Restart the stream from the first event
+     */
+    void Reset()
+    {
+        rng = WorkloadRng(seed);
+        phaseIndex = 0;
+        phaseEvents = 0;
+        now = 0;
+        freeSlots.clear();
+        slotCount = 0;
+        order.clear();
+        deaths.clear();
+        if (!phases.empty())
+        {
+            StartPhase();
+        }
+    }
+
+    /**
+     * Produce the next event
+     *
+     * @param event - Receives the event
+     * @return - False once the stream has ended
+     */
+    bool Next(TraceEvent &event)
+    {
+        while (phaseIndex < phases.size() && phaseEvents >= phases[phaseIndex].events)
+        {
+            phaseIndex++;
+            phaseEvents = 0;
+            if (phaseIndex < phases.size())
+            {
+                StartPhase();
+            }
+        }
+
+        if (phaseIndex == phases.size())
+        {
+            if (!drain || LiveCount() == 0)
+            {
+                return false;
+            }
+            FreeNext(event);
+        }
+        else if (WantsAllocation())
+        {
+            AllocateNext(event);
+        }
+        else
+        {
+            FreeNext(event);
+        }
+
+        phaseEvents++;
+        now++;
+        return true;
+    }
+
+    /**
+     * Number of slots handed out so far (the handle table size a consumer
+     * needs)
+     */
+    size_t SlotCount() const
+    {
+        return slotCount;
+    }
+
+    /**
+     * Number of live blocks
+     */
+    size_t LiveCount() const
+    {
+        return order.size() + deaths.size();
+    }
+
+    /**
+     * Total number of events the stream produces, drain excluded
+     */
+    uint64_t PlannedEvents() const
+    {
+        uint64_t total = 0;
+        for (const WorkloadPhase &phase : phases)
+        {
+            total += phase.events;
+        }
+        return total;
+    }
+
+private:
+    const WorkloadPhase &Phase() const
+    {
+        return phases[phaseIndex];
+    }
+
+    static bool UsesDeaths(LifetimeModel lifetime)
+    {
+        return lifetime == LifetimeModel::EXPONENTIAL || lifetime == LifetimeModel::OUTLIERS;
+    }
+
+    // Set up the size sampler and hand the live set to the phase's model
+    void StartPhase()
+    {
+        const WorkloadPhase &phase = Phase();
+        if (phase.sizes == SizeDistribution::ZIPF)
+        {
+            uint64_t ranks = (std::max(phase.maxSize, phase.minSize) - phase.minSize) / ALIGNMENT + 1;
+            zipf.Reset(ranks, phase.shape > 0 ? phase.shape : 1.1);
+        }
+
+        if (UsesDeaths(phase.lifetime))
+        {
+            for (uint32_t slot : order)
+            {
+                PushDeath(slot);
+            }
+            order.clear();
+        }
+        else
+        {
+            while (!deaths.empty())
+            {
+                order.push_back(PopDeath());
+            }
+        }
+    }
+
+    // Whether the next event of the current phase is an allocation
+    bool WantsAllocation()
+    {
+        const WorkloadPhase &phase = Phase();
+        if (UsesDeaths(phase.lifetime))
+        {
+            return deaths.empty() || deaths.front().first > now;
+        }
+
+        size_t live = order.size();
+        if (live == 0 || live < phase.liveTarget)
+        {
+            return true;
+        }
+        return live < 2 * phase.liveTarget && (rng.Next() & 1) == 0;
+    }
+
+    void AllocateNext(TraceEvent &event)
+    {
+        uint32_t slot;
+        if (freeSlots.empty())
+        {
+            slot = slotCount++;
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+
+        event.op = 'a';
+        event.slot = slot;
+        event.size = SampleSize();
+
+        if (UsesDeaths(Phase().lifetime))
+        {
+            PushDeath(slot);
+        }
+        else
+        {
+            order.push_back(slot);
+        }
+    }
+
+    // Free the block the lifetime model picks (the draining order is FIFO)
+    void FreeNext(TraceEvent &event)
+    {
+        uint32_t slot;
+        if (!deaths.empty())
+        {
+            slot = PopDeath();
+        }
+        else if (phaseIndex < phases.size() && Phase().lifetime == LifetimeModel::LIFO)
+        {
+            slot = order.back();
+            order.pop_back();
+        }
+        else
+        {
+            slot = order.front();
+            order.pop_front();
+        }
+
+        freeSlots.push_back(slot);
+        event.op = 'f';
+        event.slot = slot;
+        event.size = 0;
+    }
+
+    void PushDeath(uint32_t slot)
+    {
+        const WorkloadPhase &phase = Phase();
+        double lifetime = -phase.meanLifetime * std::log(rng.Unit());
+        if (phase.lifetime == LifetimeModel::OUTLIERS && rng.Unit() <= phase.outlierRate)
+        {
+            lifetime *= OUTLIER_LIFETIME_FACTOR;
+        }
+
+        // Clamp before converting: a huge mean would overflow the cast
+        // (and the death time), and the block should simply never die
+        uint64_t remaining = UINT64_MAX - now - 1;
+        uint64_t ticks = lifetime >= static_cast<double>(remaining)
+                             ? remaining
+                             : std::min(static_cast<uint64_t>(lifetime), remaining);
+        deaths.push_back({now + 1 + ticks, slot});
+        std::push_heap(deaths.begin(), deaths.end(), std::greater<Death>());
+    }
+
+    uint32_t PopDeath()
+    {
+        std::pop_heap(deaths.begin(), deaths.end(), std::greater<Death>());
+        uint32_t slot = deaths.back().second;
+        deaths.pop_back();
+        return slot;
+    }
+
+    size_t SampleSize()
+    {
+        const WorkloadPhase &phase = Phase();
+        size_t low = std::max<size_t>(phase.minSize, 1);
+        size_t high = std::max(phase.maxSize, low);
+
+        switch (phase.sizes)
+        {
+        case SizeDistribution::ZIPF:
+            return std::min(high, low + (zipf.Sample(rng) - 1) * ALIGNMENT);
+
+        case SizeDistribution::LOG_NORMAL:
+        {
+            // Box-Muller normal, so the stream does not depend on the standard library
+            double sigma = phase.shape > 0 ? phase.shape : 1.0;
+            double normal = std::sqrt(-2.0 * std::log(rng.Unit())) * std::cos(6.283185307179586 * rng.Unit());
+            double size = std::sqrt(static_cast<double>(low) * high) * std::exp(sigma * normal);
+            return static_cast<size_t>(std::min(static_cast<double>(high), std::max(static_cast<double>(low), size)));
+        }
+
+        case SizeDistribution::BIMODAL:
+        {
+            double largeShare = phase.shape > 0 ? phase.shape : 0.1;
+            if (rng.Unit() <= largeShare)
+            {
+                return rng.Range(std::max(low, high / 4), high);
+            }
+            return rng.Range(low, std::min(high, 4 * low));
+        }
+
+        case SizeDistribution::UNIFORM:
+        default:
+            return rng.Range(low, high);
+        }
+    }
+};
+
+/**
+ * Write a generated workload as a trace (see trace_replay.h for the format)
+ *
+ * @param generator - Stream to write (consumed to the end)
+ * @param out - Trace output
+ * @return - Number of events written
+ */
+inline uint64_t WriteWorkloadTrace(WorkloadGenerator &generator, std::ostream &out)
+{
+    char buffer[1 << 16];
+    size_t used = 0;
+    uint64_t events = 0;
+
+    TraceEvent event;
+    while (generator.Next(event))
+    {
+        if (used > sizeof(buffer) - 48)
+        {
+            out.write(buffer, static_cast<std::streamsize>(used));
+            used = 0;
+        }
+
+        // At most 34 characters: op, slot and size with their separators
+        char *cursor = buffer + used;
+        char *limit = cursor + 48;
+        cursor[0] = event.op;
+        cursor[1] = ' ';
+        cursor = std::to_chars(cursor + 2, limit, event.slot).ptr;
+        if (event.op == 'a')
+        {
+            *cursor = ' ';
+            cursor = std::to_chars(cursor + 1, limit, event.size).ptr;
+        }
+        *cursor++ = '\n';
+        used = static_cast<size_t>(cursor - buffer);
+        events++;
+    }
+
+    out.write(buffer, static_cast<std::streamsize>(used));
+    return events;
+}
+
+/**
+ * Run a generated workload through an allocator
+ *
+ * @param generator - Stream to run (consumed to the end)
+ * @param heap - General heap whose statistics are tracked
+ * @param front - Heap or front-end serving the events (e.g. a SlabAllocator
+ *                over heap)
+ * @param releaseLive - Free the blocks still live at the end (false leaves
+ *                      them allocated, for a heap that outlives the run)
+ * @return - Replay statistics
+ */
+template <typename Heap, typename Front>
+ReplayStats RunWorkload(WorkloadGenerator &generator, Heap &heap, Front &front, bool releaseLive = true)
+{
+    heap.SetVerbose(false);
+
+    ReplayStats stats;
+    std::vector<void *> live;
+    auto start = std::chrono::steady_clock::now();
+
+    TraceEvent event;
+    while (generator.Next(event))
+    {
+        if (event.slot >= live.size())
+        {
+            live.resize(event.slot + 1, nullptr);
+        }
+        ApplyTraceEvent(event, front, live, stats);
+
+        MemoryStats heapStats = heap.GetStats();
+        stats.peakAllocated = std::max(stats.peakAllocated, heapStats.totalAllocated);
+        stats.peakFragmentation = std::max(stats.peakFragmentation, heapStats.fragmentation);
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.finalFragmentation = heap.GetStats().fragmentation;
+
+    for (void *ptr : live)
+    {
+        if (ptr)
+        {
+            stats.liveHandles++;
+            if (releaseLive)
+            {
+                front.Deallocate(ptr);
+            }
+        }
+    }
+    return stats;
+}
+
+#endif // WORKLOAD_GENERATOR_H